@@ -19,7 +19,7 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 # THE SOFTWARE.
 
-#usage : hipconvertinplace-perl.sh DIRNAME [hipify-perl options]
+#usage : hipconvertinplace-perl.sh DIRNAME [hipify-perl-batch options, e.g. -j N to convert N files in parallel]
 
 #hipify "inplace" all code files in specified directory.
 # This can be quite handy when dealing with an existing CUDA code base since the script
@@ -34,4 +34,4 @@
 SCRIPT_DIR=`dirname $0`
 SEARCH_DIR=$1
 shift
-$SCRIPT_DIR/hipify-perl -inplace -print-stats "$@" `$SCRIPT_DIR/findcode.sh $SEARCH_DIR`
+$SCRIPT_DIR/hipify-perl-batch -inplace -print-stats "$@" `$SCRIPT_DIR/findcode.sh $SEARCH_DIR`
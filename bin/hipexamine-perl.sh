@@ -19,7 +19,7 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 # THE SOFTWARE.
 
-#usage : hipexamine-perl.sh DIRNAME [hipify-perl options]
+#usage : hipexamine-perl.sh DIRNAME [hipify-perl-batch options, e.g. -j N to examine N files in parallel]
 
 # Generate HIP stats (LOC, CUDA->API conversions, missing functionality) for all the code files
 # in the specified directory.
@@ -28,4 +28,4 @@
 SCRIPT_DIR=`dirname $0`
 SEARCH_DIR=$1
 shift
-$SCRIPT_DIR/hipify-perl -no-output -print-stats "$@" `$SCRIPT_DIR/findcode.sh $SEARCH_DIR`
+$SCRIPT_DIR/hipify-perl-batch -no-output -print-stats "$@" `$SCRIPT_DIR/findcode.sh $SEARCH_DIR`
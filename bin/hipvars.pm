@@ -20,9 +20,11 @@
 # THE SOFTWARE.
 
 package hipvars;
-use Getopt::Long;
 use Cwd;
+use Digest::MD5 qw(md5_hex);
 use File::Basename;
+use Sys::Hostname;
+use Time::HiRes qw(time);
 
 $HIP_BASE_VERSION_MAJOR = "4";
 $HIP_BASE_VERSION_MINOR = "4";
@@ -58,6 +60,80 @@ sub can_run {
     }
 }
 
+#---
+# Function to find an executable in PATH, as the shell would
+sub find_in_path {
+    my ($exe) = @_;
+    foreach my $dir (split(/:/, $ENV{'PATH'} // "")) {
+        return "$dir/$exe" if ($dir ne "" and -x "$dir/$exe");
+    }
+    return "";
+}
+
+#---
+# Probe cache: values found by running tools (compiler version, platform, GPU targets) are kept in a file,
+# so that they are not probed again on every invocation. The file is named after the paths and environment
+# the probes depend on, and is discarded when the mtime of any tool or config file it was built from changes.
+# HIPCC_PROBE_CACHE=0 disables it; HIPCC_CACHE_DIR sets its directory.
+$HIPCC_PROBE_CACHE = $ENV{'HIPCC_PROBE_CACHE'} // 1;
+# Empty variables are treated as unset, so that the cache is never placed at the root directory
+$HIPCC_CACHE_DIR = $ENV{'HIPCC_CACHE_DIR'} || ($ENV{'XDG_CACHE_HOME'} || ($ENV{'HOME'} || "/tmp") . "/.cache") . "/hipcc";
+my %probeCache = ();
+my $probeCacheFile;
+my $probeCacheStamp;
+@PROBE_TIMES = ();  # [name, seconds, cached] for every probe, reported by HIPCC_VERBOSE
+
+sub init_probe_cache {
+    my (@stampFiles) = @_;
+    return if (!$HIPCC_PROBE_CACHE or $isWindows);
+    my $key = join("\n", hostname(), $HIP_PATH, $ROCM_PATH, $CUDA_PATH, $HIP_CLANG_PATH, $HIP_INFO_PATH,
+                   $ENV{'HIP_PLATFORM'} // "", $ENV{'PATH'} // "");
+    $probeCacheFile = "$HIPCC_CACHE_DIR/probe-" . md5_hex($key);
+    $probeCacheStamp = md5_hex(join("\n", map { $_ . ":" . ((Time::HiRes::stat($_))[9] // "") } @stampFiles));
+    my %cached = ();
+    parse_config_file($probeCacheFile, \%cached);
+    if (($cached{'PROBE_STAMP'} // "") eq $probeCacheStamp) {
+        %probeCache = %cached;
+    }
+}
+
+sub save_probe_cache {
+    return unless defined $probeCacheFile;
+    require File::Path;
+    # The cache only saves time: skip it if its directory can't be created
+    File::Path::make_path(dirname($probeCacheFile), { error => \my $errors });
+    return if @$errors;
+    # Write to a temporary file first, as parallel builds run many compilers at once
+    my $tmpFile = "$probeCacheFile.$$";
+    if (open (CACHE, ">", $tmpFile)) {
+        print CACHE "PROBE_STAMP=$probeCacheStamp\n";
+        foreach my $name (sort keys %probeCache) {
+            print CACHE "$name=$probeCache{$name}\n" if $name ne 'PROBE_STAMP';
+        }
+        close(CACHE);
+        rename($tmpFile, $probeCacheFile) or unlink($tmpFile);
+    }
+}
+
+#---
+# Function to return the cached value of a probe, running it and caching its result if needed
+sub probe_cached {
+    my ($name, $probe) = @_;
+    my $start = time();
+    if (exists $probeCache{$name}) {
+        push (@PROBE_TIMES, [$name, time() - $start, 1]);
+        return $probeCache{$name};
+    }
+    my $value = $probe->();
+    push (@PROBE_TIMES, [$name, time() - $start, 0]);
+    # A probe returns undef if its result must not be cached; values are stored one per line as NAME=VALUE
+    if (defined $value and $value !~ /[=\n]/) {
+        $probeCache{$name} = $value;
+        save_probe_cache();
+    }
+    return $value;
+}
+
 $isWindows = $^O eq 'MSWin32';
 
 #
@@ -114,10 +190,21 @@ if (defined $HIP_RUNTIME and $HIP_RUNTIME eq "rocclr" and !defined $HIP_ROCCLR_H
     }
 }
 
+init_probe_cache(Cwd::realpath($0), __FILE__, $HIP_INFO_PATH, "$HIP_PATH/bin/.hipVersion",
+                 "$HIP_CLANG_PATH/clang++", "$HIP_CLANG_PATH/clang", find_in_path("clang++"),
+                 "$CUDA_PATH/bin/nvcc", find_in_path("nvcc"), "$ROCM_PATH/bin/rocm_agent_enumerator",
+                 defined $HIP_ROCCLR_HOME ? "$HIP_ROCCLR_HOME/bin/clang" : "");
+
 if (not defined $HIP_PLATFORM) {
-    if (can_run("$HIP_CLANG_PATH/clang++") or can_run("clang++")) {
-        $HIP_PLATFORM = "amd";
-    } elsif (can_run("$CUDA_PATH/bin/nvcc") or can_run("nvcc")) {
+    my $detected_platform = probe_cached('DETECTED_HIP_PLATFORM', sub {
+        if (can_run("$HIP_CLANG_PATH/clang++") or can_run("clang++")) {
+            return "amd";
+        } elsif (can_run("$CUDA_PATH/bin/nvcc") or can_run("nvcc")) {
+            return "nvidia";
+        }
+        return "";
+    });
+    if ($detected_platform eq "nvidia") {
         $HIP_PLATFORM = "nvidia";
         $HIP_COMPILER = "nvcc";
         $HIP_RUNTIME = "cuda";
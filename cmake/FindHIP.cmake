@@ -300,6 +300,15 @@ hip_find_helper_file(run_make2cmake cmake)
 hip_find_helper_file(run_hipcc cmake)
 ###############################################################################
 
+# Generators that take the dependency file written by the compiler through
+# DEPFILE; the others include a cmake readable copy of it at configure time.
+if(("${CMAKE_GENERATOR}" STREQUAL "Ninja" AND NOT CMAKE_VERSION VERSION_LESS 3.7) OR
+   (CMAKE_GENERATOR MATCHES "Ninja|Makefiles" AND NOT CMAKE_VERSION VERSION_LESS 3.20))
+    set(HIP_USE_DEPFILE TRUE)
+else()
+    set(HIP_USE_DEPFILE FALSE)
+endif()
+
 ###############################################################################
 # MACRO: Reset compiler flags
 ###############################################################################
@@ -569,7 +578,12 @@ macro(HIP_PREPARE_TARGET_COMMANDS _target _format _generated_files _source_files
 
             # Set file names
             set(generated_file "${generated_file_path}/${generated_file_basename}")
-            set(cmake_dependency_file "${hip_compile_output_dir}/${generated_file_basename}.depend")
+            set(hipcc_dependency_file "${hip_compile_output_dir}/${generated_file_basename}.d")
+            if(HIP_USE_DEPFILE)
+                set(cmake_dependency_file "")
+            else()
+                set(cmake_dependency_file "${hip_compile_output_dir}/${generated_file_basename}.depend")
+            endif()
             set(custom_target_script_pregen "${hip_compile_output_dir}/${generated_file_basename}.cmake.pre-gen")
             set(custom_target_script "${hip_compile_output_dir}/${generated_file_basename}.cmake")
 
@@ -588,7 +602,13 @@ macro(HIP_PREPARE_TARGET_COMMANDS _target _format _generated_files _source_files
             endif()
 
             # Bring in the dependencies
-            HIP_INCLUDE_HIPCC_DEPENDENCIES(${cmake_dependency_file})
+            if(HIP_USE_DEPFILE)
+                set(HIP_HIPCC_DEPEND)
+                set(hip_depfile DEPFILE "${hipcc_dependency_file}")
+            else()
+                HIP_INCLUDE_HIPCC_DEPENDENCIES(${cmake_dependency_file})
+                set(hip_depfile)
+            endif()
 
             # Configure the build script
             configure_file("${HIP_run_hipcc}" "${custom_target_script_pregen}" @ONLY)
@@ -612,10 +632,12 @@ macro(HIP_PREPARE_TARGET_COMMANDS _target _format _generated_files _source_files
             # Build the generated file and dependency file
             add_custom_command(
                 OUTPUT ${generated_file}
-                # These output files depend on the source_file and the contents of cmake_dependency_file
+                # These output files depend on the source_file and the headers it includes,
+                # from either hipcc_dependency_file or the contents of cmake_dependency_file
                 ${main_dep}
                 DEPENDS ${HIP_HIPCC_DEPEND}
                 DEPENDS ${custom_target_script}
+                ${hip_depfile}
                 # Make sure the output directory exists before trying to write to it.
                 COMMAND ${CMAKE_COMMAND} -E make_directory "${generated_file_path}"
                 COMMAND ${CMAKE_COMMAND} ARGS
@@ -26,6 +26,11 @@
 # This file runs the hipcc commands to produce the desired output file
 # along with the dependency file needed by CMake to compute dependencies.
 #
+# The object and its dependency file come from a single compiler invocation
+# (-MD -MF). With generators that read it through DEPFILE, the dependency file
+# is used as is; otherwise it is converted to the cmake readable
+# cmake_dependency_file, which FindHIP includes at configure time.
+#
 # Input variables:
 #
 # verbose:BOOL=<>               OFF: Be as quiet as possible (default)
@@ -42,7 +47,6 @@ endif()
 
 # Set these up as variables to make reading the generated file easier
 set(HIP_HIPCC_EXECUTABLE "@HIP_HIPCC_EXECUTABLE@") # path
-set(HIP_HIPCONFIG_EXECUTABLE "@HIP_HIPCONFIG_EXECUTABLE@") #path
 set(HIP_HOST_COMPILER "@HIP_HOST_COMPILER@") # path
 set(CMAKE_COMMAND "@CMAKE_COMMAND@") # path
 set(HIP_run_make2cmake "@HIP_run_make2cmake@") # path
@@ -56,14 +60,17 @@ set(HIP_CLANG_PARALLEL_BUILD_COMPILE_OPTIONS "@HIP_CLANG_PARALLEL_BUILD_COMPILE_
 #Needed to bring the HIP_HIPCC_INCLUDE_ARGS variable in scope
 set(HIP_HIPCC_INCLUDE_ARGS @HIP_HIPCC_INCLUDE_ARGS@) # list
 
-set(cmake_dependency_file "@cmake_dependency_file@") # path
+set(hipcc_dependency_file "@hipcc_dependency_file@") # path
+set(cmake_dependency_file "@cmake_dependency_file@") # path, empty with DEPFILE
 set(source_file "@source_file@") # path
 set(host_flag "@host_flag@") # bool
 
+# Computed by hipconfig when FindHIP was run
+set(HIP_PLATFORM "@HIP_PLATFORM@")
+set(HIP_COMPILER "@HIP_COMPILER@")
+set(HIP_RUNTIME "@HIP_RUNTIME@")
+
 # Determine compiler and compiler flags
-execute_process(COMMAND ${HIP_HIPCONFIG_EXECUTABLE} --platform OUTPUT_VARIABLE HIP_PLATFORM OUTPUT_STRIP_TRAILING_WHITESPACE)
-execute_process(COMMAND ${HIP_HIPCONFIG_EXECUTABLE} --compiler OUTPUT_VARIABLE HIP_COMPILER OUTPUT_STRIP_TRAILING_WHITESPACE)
-execute_process(COMMAND ${HIP_HIPCONFIG_EXECUTABLE} --runtime OUTPUT_VARIABLE HIP_RUNTIME OUTPUT_STRIP_TRAILING_WHITESPACE)
 if(NOT host_flag)
     set(__CC ${HIP_HIPCC_EXECUTABLE})
     if("${HIP_PLATFORM}" STREQUAL "amd")
@@ -114,59 +121,7 @@ macro(hip_execute_process status command)
 endmacro()
 
 # Delete the target file
-hip_execute_process(
-    "Removing ${generated_file}"
-    COMMAND "${CMAKE_COMMAND}" -E remove "${generated_file}"
-    )
-
-# Generate the dependency file
-hip_execute_process(
-    "Generating dependency file: ${cmake_dependency_file}.pre"
-    COMMAND "${__CC}"
-    -M
-    "${source_file}"
-    -o "${cmake_dependency_file}.pre"
-    ${__CC_FLAGS}
-    ${__CC_INCLUDES}
-    )
-
-if(HIP_result)
-    message(FATAL_ERROR "Error generating ${generated_file}")
-endif()
-
-# Generate the cmake readable dependency file to a temp file
-hip_execute_process(
-    "Generating temporary cmake readable file: ${cmake_dependency_file}.tmp"
-    COMMAND "${CMAKE_COMMAND}"
-    -D "input_file:FILEPATH=${cmake_dependency_file}.pre"
-    -D "output_file:FILEPATH=${cmake_dependency_file}.tmp"
-    -D "verbose=${verbose}"
-    -P "${HIP_run_make2cmake}"
-    )
-
-if(HIP_result)
-    message(FATAL_ERROR "Error generating ${generated_file}")
-endif()
-
-# Copy the file if it is different
-hip_execute_process(
-    "Copy if different ${cmake_dependency_file}.tmp to ${cmake_dependency_file}"
-    COMMAND "${CMAKE_COMMAND}" -E copy_if_different "${cmake_dependency_file}.tmp" "${cmake_dependency_file}"
-    )
-
-if(HIP_result)
-    message(FATAL_ERROR "Error generating ${generated_file}")
-endif()
-
-# Delete the temporary file
-hip_execute_process(
-    "Removing ${cmake_dependency_file}.tmp and ${cmake_dependency_file}.pre"
-    COMMAND "${CMAKE_COMMAND}" -E remove "${cmake_dependency_file}.tmp" "${cmake_dependency_file}.pre"
-    )
-
-if(HIP_result)
-    message(FATAL_ERROR "Error generating ${generated_file}")
-endif()
+file(REMOVE "${generated_file}")
 
 # Generate the output file
 hip_execute_process(
@@ -175,20 +130,31 @@ hip_execute_process(
     -c
     "${source_file}"
     -o "${generated_file}"
+    -MD -MF "${hipcc_dependency_file}"
     ${__CC_FLAGS}
     ${__CC_INCLUDES}
     )
 
 if(HIP_result)
     # Make sure that we delete the output file
-    hip_execute_process(
-        "Removing ${generated_file}"
-        COMMAND "${CMAKE_COMMAND}" -E remove "${generated_file}"
-        )
+    file(REMOVE "${generated_file}")
     message(FATAL_ERROR "Error generating file ${generated_file}")
 else()
     if(verbose)
         message("Generated ${generated_file} successfully.")
     endif()
 endif()
+
+if(cmake_dependency_file)
+    # Generate the cmake readable dependency file, and only touch it if it is
+    # different, so the dependencies do not force cmake to rerun
+    if(verbose)
+        message("Generating cmake readable file: ${cmake_dependency_file}")
+    endif()
+    set(input_file "${hipcc_dependency_file}")
+    set(output_file "${cmake_dependency_file}.tmp")
+    include("${HIP_run_make2cmake}")
+    configure_file("${cmake_dependency_file}.tmp" "${cmake_dependency_file}" COPYONLY)
+    file(REMOVE "${cmake_dependency_file}.tmp" "${hipcc_dependency_file}")
+endif()
 # vim: ts=4:sw=4:expandtab:smartindent
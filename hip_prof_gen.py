@@ -98,6 +98,10 @@ def filtr_api_types(args_str):
     types_str += arg_tuple[0] + ', '
   return types_str
 
+# Checking if the argument is a string, traced by its content as it is printed
+def is_string_type(type_str):
+  return re.match(r'^(const )?char\*$', type_str) != None
+
 # Creating options list [opt0, opt1, ...]
 def filtr_api_opts(args_str):
   args_list = list_api_args(args_str)
@@ -316,6 +320,304 @@ def parse_src(api_map, src_path, src_patt, out):
             f.write(content)
             f.close()
 #############################################################
+# Generating the binary trace record encoder and decoder
+# Every record is a header followed by the arguments of the call packed in their declaration
+# order, each as its raw bytes, except strings which are stored as their length and content.
+# api_map - public API map [<api name>] => [(type, name), ...]
+def generate_trace_coder(f, api_map):
+  f.write('\n#if HIP_PROF_HIP_API_TRACE\n')
+  f.write('#include <string.h>\n')
+  f.write('#define HIP_API_TRACE_VER 1\n')
+  f.write('// Longer strings are truncated\n')
+  f.write('#ifndef HIP_API_TRACE_STRING_MAX\n')
+  f.write('#define HIP_API_TRACE_STRING_MAX 4096\n')
+  f.write('#endif\n')
+  f.write('#define HIP_API_TRACE_NULL_STRING 0xffffffffu\n')
+  f.write(
+  '\n// HIP API trace record header, followed by the packed arguments\n' +
+  'typedef struct hip_api_trace_record_t {\n' +
+  '  uint32_t size;  // of the whole record, a multiple of 8 bytes\n' +
+  '  uint16_t id;\n' +
+  '  uint16_t phase;\n' +
+  '  uint64_t correlation_id;\n' +
+  '} hip_api_trace_record_t;\n'
+  )
+  f.write(
+  '\n' +
+  'static inline uint32_t hip_api_trace_string_length(const char* str) {\n' +
+  '  uint32_t len = 0;\n' +
+  '  if (str == NULL) return HIP_API_TRACE_NULL_STRING;\n' +
+  '  while (len < HIP_API_TRACE_STRING_MAX && str[len] != \'\\0\') len++;\n' +
+  '  return len;\n' +
+  '}\n' +
+  'static inline size_t hip_api_trace_string_size(const char* str) {\n' +
+  '  return (str == NULL) ? sizeof(uint32_t) : sizeof(uint32_t) + hip_api_trace_string_length(str) + 1;\n' +
+  '}\n' +
+  'static inline char* hip_api_trace_put(char* p, const void* value, size_t size) {\n' +
+  '  memcpy(p, value, size);\n' +
+  '  return p + size;\n' +
+  '}\n' +
+  'static inline char* hip_api_trace_put_string(char* p, const char* str) {\n' +
+  '  uint32_t len = hip_api_trace_string_length(str);\n' +
+  '  p = hip_api_trace_put(p, &len, sizeof(len));\n' +
+  '  if (str == NULL) return p;\n' +
+  '  memcpy(p, str, len);\n' +
+  '  p[len] = \'\\0\';\n' +
+  '  return p + len + 1;\n' +
+  '}\n' +
+  'static inline const char* hip_api_trace_get(const char* p, const char* end, void* value, size_t size) {\n' +
+  '  if (p == NULL || (size_t)(end - p) < size) return NULL;\n' +
+  '  memcpy(value, p, size);\n' +
+  '  return p + size;\n' +
+  '}\n' +
+  '// Strings are not copied: they point into the record\n' +
+  'static inline const char* hip_api_trace_get_string(const char* p, const char* end, const char** str) {\n' +
+  '  uint32_t len;\n' +
+  '  *str = NULL;\n' +
+  '  p = hip_api_trace_get(p, end, &len, sizeof(len));\n' +
+  '  if (p == NULL || len == HIP_API_TRACE_NULL_STRING) return p;\n' +
+  '  if ((size_t)(end - p) <= len || p[len] != \'\\0\') return NULL;\n' +
+  '  *str = p;\n' +
+  '  return p + len + 1;\n' +
+  '}\n'
+  )
+
+  # Record size
+  f.write('\n// Size of the HIP API trace record of a call\n')
+  f.write('static inline size_t hipApiTraceSize(uint32_t id, const hip_api_data_t* data) {\n')
+  f.write('  size_t size = sizeof(hip_api_trace_record_t);\n')
+  f.write('  switch (id) {\n')
+  for name, args in api_map.items():
+    if len(args) == 0: continue
+    f.write('    case HIP_API_ID_' + name + ':\n')
+    for arg_tuple in args:
+      fld = 'data->args.' + name + '.' + arg_tuple[1]
+      if is_string_type(arg_tuple[0]):
+        f.write('      size += hip_api_trace_string_size(' + fld + ');\n')
+      else:
+        f.write('      size += sizeof(' + fld + ');\n')
+    f.write('      break;\n')
+  f.write('    default: break;\n')
+  f.write('  };\n')
+  f.write('  return (size + 7) & ~(size_t)7;\n')
+  f.write('};\n')
+
+  # Encoder
+  f.write('\n// Writing the HIP API trace record of a call, without allocating, e.g. in a ring buffer.\n')
+  f.write('// Returns the record size; nothing is written if it is larger than the capacity.\n')
+  f.write('static inline size_t hipApiTraceEncode(uint32_t id, const hip_api_data_t* data, void* buffer, size_t capacity) {\n')
+  f.write('  hip_api_trace_record_t record;\n')
+  f.write('  size_t size = hipApiTraceSize(id, data);\n')
+  f.write('  char* p = (char*)buffer + sizeof(record);\n')
+  f.write('  if (size > capacity) return size;\n')
+  f.write('  record.size = (uint32_t)size;\n')
+  f.write('  record.id = (uint16_t)id;\n')
+  f.write('  record.phase = (uint16_t)data->phase;\n')
+  f.write('  record.correlation_id = data->correlation_id;\n')
+  f.write('  memcpy(buffer, &record, sizeof(record));\n')
+  f.write('  switch (id) {\n')
+  for name, args in api_map.items():
+    if len(args) == 0: continue
+    f.write('    case HIP_API_ID_' + name + ':\n')
+    for arg_tuple in args:
+      fld = 'data->args.' + name + '.' + arg_tuple[1]
+      if is_string_type(arg_tuple[0]):
+        f.write('      p = hip_api_trace_put_string(p, ' + fld + ');\n')
+      else:
+        f.write('      p = hip_api_trace_put(p, &' + fld + ', sizeof(' + fld + '));\n')
+    f.write('      break;\n')
+  f.write('    default: break;\n')
+  f.write('  };\n')
+  f.write('  memset(p, 0, (char*)buffer + size - p);\n')
+  f.write('  return size;\n')
+  f.write('};\n')
+
+  # Decoder
+  f.write('\n// Reading a HIP API trace record back, strings pointing into the record.\n')
+  f.write('// Returns 0 if the record is truncated or invalid.\n')
+  f.write('static inline int hipApiTraceDecode(const void* buffer, size_t size, uint32_t* id, hip_api_data_t* data) {\n')
+  f.write('  hip_api_trace_record_t record;\n')
+  f.write('  const char* p = (const char*)buffer + sizeof(record);\n')
+  f.write('  const char* end;\n')
+  f.write('  const char* str;\n')
+  f.write('  if (size < sizeof(record)) return 0;\n')
+  f.write('  memcpy(&record, buffer, sizeof(record));\n')
+  f.write('  if (record.size < sizeof(record) || record.size > size || record.id >= HIP_API_ID_NUMBER) return 0;\n')
+  f.write('  end = (const char*)buffer + record.size;\n')
+  f.write('  memset((void*)data, 0, sizeof(*data));\n')
+  f.write('  *id = record.id;\n')
+  f.write('  data->phase = record.phase;\n')
+  f.write('  data->correlation_id = record.correlation_id;\n')
+  f.write('  switch (*id) {\n')
+  for name, args in api_map.items():
+    if len(args) == 0: continue
+    f.write('    case HIP_API_ID_' + name + ':\n')
+    for arg_tuple in args:
+      fld = 'data->args.' + name + '.' + arg_tuple[1]
+      if is_string_type(arg_tuple[0]):
+        f.write('      p = hip_api_trace_get_string(p, end, &str);\n')
+        f.write('      ' + fld + ' = (' + arg_tuple[0] + ')str;\n')
+      else:
+        f.write('      p = hip_api_trace_get(p, end, &' + fld + ', sizeof(' + fld + '));\n')
+    f.write('      break;\n')
+  f.write('    default: break;\n')
+  f.write('  };\n')
+  f.write('  return p != NULL;\n')
+  f.write('};\n')
+  f.write('#endif  // HIP_PROF_HIP_API_TRACE\n')
+
+#############################################################
+# Generating the API reflection tables
+# Argument normalized type, without redundant spaces
+def norm_arg_type(type_str):
+  return re.sub(r'\s*\*', '*', ' '.join(type_str.split()))
+
+# Checking if the argument points to memory; hipDeviceptr_t is a device address
+def is_pointer_type(type_str):
+  return type_str[-1] == '*' or type_str == 'hipDeviceptr_t'
+
+# Checking if the argument is a buffer a size can refer to, not a returned handle or pointer,
+# e.g. hipMalloc void** ptr or hipStreamCreate hipStream_t* stream
+def is_buffer_type(type_str):
+  if not is_pointer_type(type_str): return False
+  if re.search(r'\*\*$', type_str): return False
+  if re.match(r'^(hipArray|hip\w+_t)\*$', type_str): return False
+  return True
+
+# Checking if the argument is a size or a count of elements, by its name
+def is_size_arg(arg_tuple):
+  if not re.match(r'^(unsigned int|int|size_t|uint32_t|uint64_t)$', arg_tuple[0]): return False
+  return re.match(r'^(size|sizeBytes|count|len|length|data_size|cuMaskSize)$', arg_tuple[1]) != None
+
+def is_count_arg(arg_tuple):
+  if not re.match(r'^(unsigned int|int|size_t)$', arg_tuple[0]): return False
+  return re.match(r'^num(_\w+|[A-Z]\w*)$', arg_tuple[1]) != None
+
+# Pairing sizes with the pointers they refer to
+# Returns the list of the paired argument index for every argument, -1 if none
+# A size goes with the nearest buffer before it, else with the one after it, and also with the
+# buffers before it since the previous size, e.g. hipMemcpy dst and src with sizeBytes.
+# A count of elements goes with the buffer named after it, else with the one just before it,
+# e.g. hipModuleLoadDataEx numOptions with options.
+def pair_size_args(args):
+  types = [norm_arg_type(a[0]) for a in args]
+  pairs = [-1] * len(args)
+  last = -1
+  for ind in range(0, len(args)):
+    if is_size_arg(args[ind]):
+      cand = [i for i in range(ind - 1, -1, -1) if is_buffer_type(types[i])]
+      cand += [i for i in range(ind + 1, len(args)) if is_buffer_type(types[i])]
+      if len(cand) != 0:
+        pairs[ind] = cand[0]
+        for i in range(last + 1, ind):
+          if is_buffer_type(types[i]) and pairs[i] == -1: pairs[i] = ind
+        if pairs[cand[0]] == -1: pairs[cand[0]] = ind
+      last = ind
+    elif is_count_arg(args[ind]):
+      stem = re.sub(r'^num_?', '', args[ind][1]).rstrip('s').lower()
+      cand = [i for i in range(0, len(args)) if is_buffer_type(types[i]) and stem in args[i][1].lower()]
+      if len(cand) == 0 and ind > 0 and is_buffer_type(types[ind - 1]): cand = [ind - 1]
+      if len(cand) != 0 and pairs[cand[0]] == -1:
+        pairs[ind] = cand[0]
+        pairs[cand[0]] = ind
+      last = ind
+  return pairs
+
+# Pairs of a few APIs, checked on every run to test the heuristics above: the allocations
+# return a pointer, which no size goes with, and hipMemcpy sizeBytes goes with src and dst
+known_pairs = {
+  'hipMalloc': [-1, -1],
+  'hipHostMalloc': [-1, -1, -1],
+  'hipMallocManaged': [-1, -1, -1],
+  'hipMemcpy': [2, 2, 1, -1],
+  'hipMemcpyAsync': [2, 2, 1, -1, -1],
+}
+
+# Non-const pointers that are only read by the call, exceptions to the const-ness rule of
+# HIP_API_ARG_IN and HIP_API_ARG_OUT: host sources declared void*, and the arrays of kernel
+# arguments of launches. Checked on every run, so that renamed arguments are noticed.
+input_args = {
+  'hipMemcpyHtoD': ['src'],
+  'hipMemcpyHtoDAsync': ['src'],
+  'hipModuleLaunchKernel': ['kernelParams', 'extra'],
+  'hipLaunchCooperativeKernel': ['kernelParams'],
+  'hipLaunchKernel': ['args'],
+  'hipExtLaunchKernel': ['args'],
+}
+
+def check_input_args(api_map):
+  for name, inputs in input_args.items():
+    if not name in api_map: continue
+    names = [a[1] for a in api_map[name]]
+    for arg in inputs:
+      if not arg in names: fatal("bad input argument of " + name + ": " + arg)
+
+def check_pairs(api_map):
+  for name, expected in known_pairs.items():
+    if not name in api_map: continue
+    pairs = pair_size_args(api_map[name])
+    if pairs != expected:
+      fatal("bad size pairs of " + name + ": " + str(pairs) + ", expected " + str(expected))
+
+# api_map - public API map [<api name>] => [(type, name), ...]
+def generate_reflection(f, api_map):
+  check_pairs(api_map)
+  check_input_args(api_map)
+  f.write('\n#if HIP_PROF_HIP_API_REFLECTION\n')
+  f.write('#if !defined(__cplusplus) || __cplusplus < 201103L\n')
+  f.write('#error "HIP API reflection tables require C++11"\n')
+  f.write('#endif\n')
+  f.write('// HIP API argument flags\n')
+  f.write('#define HIP_API_ARG_POINTER 0x1  // points to memory\n')
+  f.write('#define HIP_API_ARG_IN 0x2       // pointer to const, or known to be only read by the call\n')
+  f.write('#define HIP_API_ARG_OUT 0x4      // other pointer to non-const, may be written by the call\n')
+  f.write('#define HIP_API_ARG_STRING 0x8   // NUL terminated string\n')
+  f.write('#define HIP_API_ARG_SIZE 0x10    // size or count of the memory a pointer argument points to\n')
+  f.write(
+  '\n// HIP API argument descriptor\n' +
+  'struct hip_api_arg_desc_t {\n' +
+  '  const char* name;\n' +
+  '  const char* type;\n' +
+  '  size_t size;\n' +
+  '  uint32_t flags;\n' +
+  '  int pair;  // index of the pointer a size goes with, or of the size of a pointer, -1 if none\n' +
+  '};\n' +
+  '\n// HIP API descriptor, hip_api_desc[id]\n' +
+  'struct hip_api_desc_t {\n' +
+  '  const char* name;\n' +
+  '  uint32_t arg_count;\n' +
+  '  const hip_api_arg_desc_t* args;\n' +
+  '};\n\n'
+  )
+  for name, args in api_map.items():
+    if len(args) == 0: continue
+    pairs = pair_size_args(args)
+    f.write('static constexpr hip_api_arg_desc_t hip_api_args_' + name + '[] = {\n')
+    for ind in range(0, len(args)):
+      arg_type = norm_arg_type(args[ind][0])
+      flags = []
+      if is_pointer_type(arg_type):
+        flags.append('HIP_API_ARG_POINTER')
+        if re.match(r'^const ', arg_type) or args[ind][1] in input_args.get(name, []):
+          flags.append('HIP_API_ARG_IN')
+        elif arg_type[-1] == '*': flags.append('HIP_API_ARG_OUT')
+        if is_string_type(arg_type): flags.append('HIP_API_ARG_STRING')
+      elif pairs[ind] != -1:
+        flags.append('HIP_API_ARG_SIZE')
+      if len(flags) == 0: flags.append('0')
+      f.write('  {"' + args[ind][1] + '", "' + arg_type + '", sizeof(' + arg_type + '), ' +
+              ' | '.join(flags) + ', ' + str(pairs[ind]) + '},\n')
+    f.write('};\n')
+  f.write('\nstatic constexpr hip_api_desc_t hip_api_desc[HIP_API_ID_NUMBER] = {\n')
+  for name, args in api_map.items():
+    if len(args) == 0:
+      f.write('  {"' + name + '", 0, nullptr},\n')
+    else:
+      f.write('  {"' + name + '", ' + str(len(args)) + ', hip_api_args_' + name + '},\n')
+  f.write('};\n')
+  f.write('#endif  // HIP_PROF_HIP_API_REFLECTION\n')
+
+#############################################################
 # Generating profiling primitives header
 # api_map - public API map [<api name>] => [(type, name), ...]
 # opts_map - opts map  [<api name>] => [opt0, opt1, ...]
@@ -407,6 +709,12 @@ def generate_prof_header(f, api_map, opts_map):
         f.write('  cb_data.args.' + name + '.' + fld_name + ' = ' + arg_name + '; \\\n')
     f.write('};\n')
   f.write('#define INIT_CB_ARGS_DATA(cb_id, cb_data) INIT_##cb_id##_CB_ARGS_DATA(cb_data)\n')
+
+  # Generating the binary trace record encoder and decoder
+  generate_trace_coder(f, api_map)
+
+  # Generating the API reflection tables
+  generate_reflection(f, api_map)
   
   # Generating the method for the API string, name and parameters
   f.write('\n')
@@ -431,6 +739,17 @@ def generate_prof_header(f, api_map, opts_map):
   f.write('  };\n')
   f.write('  return strdup(oss.str().c_str());\n')
   f.write('};\n')
+  f.write('#if HIP_PROF_HIP_API_TRACE\n')
+  f.write('// HIP API string of a binary trace record, the same as hipApiString gives for the call\n')
+  f.write('const char* hipApiTraceString(const void* record, size_t size) {\n')
+  f.write('  uint32_t id;\n')
+  f.write('  // hip_api_data_t is not default constructible, dim3 has a constructor\n')
+  f.write('  alignas(hip_api_data_t) char storage[sizeof(hip_api_data_t)];\n')
+  f.write('  hip_api_data_t* data = reinterpret_cast<hip_api_data_t*>(storage);\n')
+  f.write('  if (!hipApiTraceDecode(record, size, &id, data)) return strdup("invalid record");\n')
+  f.write('  return hipApiString((hip_api_id_t)id, data);\n')
+  f.write('};\n')
+  f.write('#endif  // HIP_PROF_HIP_API_TRACE\n')
   f.write('#endif  // HIP_PROF_HIP_API_STRING\n')
   
   f.write('#endif  // _HIP_PROF_STR_H\n');
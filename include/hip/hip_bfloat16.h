@@ -29,6 +29,17 @@
 #ifndef _HIP_BFLOAT16_H_
 #define _HIP_BFLOAT16_H_
 
+// hip_bfloat162 is aligned to 32 bits, so that a pair is loaded and stored as one word
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define __HIP_BFLOAT162_ALIGN alignas(4)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define __HIP_BFLOAT162_ALIGN _Alignas(4)
+#elif defined(_MSC_VER)
+#define __HIP_BFLOAT162_ALIGN __declspec(align(4))
+#else
+#define __HIP_BFLOAT162_ALIGN __attribute__((aligned(4)))
+#endif
+
 #if __cplusplus < 201103L || !defined(__HIPCC__)
 
 // If this is a C compiler, C++ compiler below C++11, or a host-only compiler, we only
@@ -41,6 +52,13 @@ typedef struct
     uint16_t data;
 } hip_bfloat16;
 
+/*! \brief Struct to represent a pair of 16 bit brain floating point numbers. */
+typedef struct
+{
+    __HIP_BFLOAT162_ALIGN hip_bfloat16 x;
+    hip_bfloat16                       y;
+} hip_bfloat162;
+
 #else // __cplusplus < 201103L || !defined(__HIPCC__)
 
 #include <cmath>
@@ -50,6 +68,39 @@ typedef struct
 #include <ostream>
 #include <type_traits>
 
+// The conversions are constexpr when the compiler can bit cast between float and uint32_t in
+// constant expressions (__builtin_bit_cast in clang 9 and gcc 11 onwards, or C++20 std::bit_cast),
+// so that tables of bfloat16 constants can be computed at compile time.
+// HIP_BFLOAT16_CONSTEXPR_CONVERSIONS tells whether they are.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_bit_cast)
+#define __HIP_BFLOAT16_BIT_CAST(T, v) __builtin_bit_cast(T, v)
+#endif
+#endif
+#if !defined(__HIP_BFLOAT16_BIT_CAST) && __cplusplus > 201703L && defined(__has_include)
+#if __has_include(<bit>)
+#include <bit>
+#if defined(__cpp_lib_bit_cast)
+#define __HIP_BFLOAT16_BIT_CAST(T, v) std::bit_cast<T>(v)
+#endif
+#endif
+#endif
+
+#ifdef __HIP_BFLOAT16_BIT_CAST
+#define HIP_BFLOAT16_CONSTEXPR_CONVERSIONS 1
+#define __HIP_BFLOAT16_CONSTEXPR constexpr
+#else
+#define HIP_BFLOAT16_CONSTEXPR_CONVERSIONS 0
+#define __HIP_BFLOAT16_CONSTEXPR
+#endif
+
+// Functions that modify their arguments can only be constexpr from C++14 onwards
+#if defined(__HIP_BFLOAT16_BIT_CAST) && __cplusplus >= 201402L
+#define __HIP_BFLOAT16_CONSTEXPR14 constexpr
+#else
+#define __HIP_BFLOAT16_CONSTEXPR14
+#endif
+
 struct hip_bfloat16
 {
     uint16_t data;
@@ -59,96 +110,130 @@ struct hip_bfloat16
         truncate
     };
 
+    enum from_bits_t
+    {
+        from_bits
+    };
+
     __host__ __device__ hip_bfloat16() = default;
 
     // round upper 16 bits of IEEE float to convert to bfloat16
-    explicit __host__ __device__ hip_bfloat16(float f)
+    explicit __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16(float f)
         : data(float_to_bfloat16(f))
     {
     }
 
-    explicit __host__ __device__ hip_bfloat16(float f, truncate_t)
+    explicit __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16(float f, truncate_t)
         : data(truncate_float_to_bfloat16(f))
     {
     }
 
+    // use the bits of a bfloat16 as they are, e.g. hip_bfloat16(0x7fc0, hip_bfloat16::from_bits)
+    constexpr __host__ __device__ hip_bfloat16(uint16_t bits, from_bits_t)
+        : data(bits)
+    {
+    }
+
     // zero extend lower 16 bits of bfloat16 to convert to IEEE float
-    __host__ __device__ operator float() const
+    __HIP_BFLOAT16_CONSTEXPR __host__ __device__ operator float() const
     {
-        union
-        {
-            uint32_t int32;
-            float    fp32;
-        } u = {uint32_t(data) << 16};
-        return u.fp32;
+        return bits_to_float(uint32_t(data) << 16);
     }
 
-    static  __host__ __device__ hip_bfloat16 round_to_bfloat16(float f)
+    static __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 round_to_bfloat16(float f)
     {
-        hip_bfloat16 output;
-        output.data = float_to_bfloat16(f);
-        return output;
+        return hip_bfloat16(float_to_bfloat16(f), from_bits);
     }
 
-    static  __host__ __device__ hip_bfloat16 round_to_bfloat16(float f, truncate_t)
+    static __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 round_to_bfloat16(float f,
+                                                                                      truncate_t)
     {
-        hip_bfloat16 output;
-        output.data = truncate_float_to_bfloat16(f);
-        return output;
+        return hip_bfloat16(truncate_float_to_bfloat16(f), from_bits);
     }
 
 private:
-    static __host__ __device__ uint16_t float_to_bfloat16(float f)
+#ifdef __HIP_BFLOAT16_BIT_CAST
+    static constexpr __host__ __device__ uint32_t float_to_bits(float f)
+    {
+        return __HIP_BFLOAT16_BIT_CAST(uint32_t, f);
+    }
+
+    static constexpr __host__ __device__ float bits_to_float(uint32_t bits)
+    {
+        return __HIP_BFLOAT16_BIT_CAST(float, bits);
+    }
+#else
+    static __host__ __device__ uint32_t float_to_bits(float f)
     {
         union
         {
             float    fp32;
             uint32_t int32;
         } u = {f};
-        if(~u.int32 & 0x7f800000)
-        {
-            // When the exponent bits are not all 1s, then the value is zero, normal,
-            // or subnormal. We round the bfloat16 mantissa up by adding 0x7FFF, plus
-            // 1 if the least significant bit of the bfloat16 mantissa is 1 (odd).
-            // This causes the bfloat16's mantissa to be incremented by 1 if the 16
-            // least significant bits of the float mantissa are greater than 0x8000,
-            // or if they are equal to 0x8000 and the least significant bit of the
-            // bfloat16 mantissa is 1 (odd). This causes it to be rounded to even when
-            // the lower 16 bits are exactly 0x8000. If the bfloat16 mantissa already
-            // has the value 0x7f, then incrementing it causes it to become 0x00 and
-            // the exponent is incremented by one, which is the next higher FP value
-            // to the unrounded bfloat16 value. When the bfloat16 value is subnormal
-            // with an exponent of 0x00 and a mantissa of 0x7F, it may be rounded up
-            // to a normal value with an exponent of 0x01 and a mantissa of 0x00.
-            // When the bfloat16 value has an exponent of 0xFE and a mantissa of 0x7F,
-            // incrementing it causes it to become an exponent of 0xFF and a mantissa
-            // of 0x00, which is Inf, the next higher value to the unrounded value.
-            u.int32 += 0x7fff + ((u.int32 >> 16) & 1); // Round to nearest, round to even
-        }
-        else if(u.int32 & 0xffff)
-        {
-            // When all of the exponent bits are 1, the value is Inf or NaN.
-            // Inf is indicated by a zero mantissa. NaN is indicated by any nonzero
-            // mantissa bit. Quiet NaN is indicated by the most significant mantissa
-            // bit being 1. Signaling NaN is indicated by the most significant
-            // mantissa bit being 0 but some other bit(s) being 1. If any of the
-            // lower 16 bits of the mantissa are 1, we set the least significant bit
-            // of the bfloat16 mantissa, in order to preserve signaling NaN in case
-            // the bloat16's mantissa bits are all 0.
-            u.int32 |= 0x10000; // Preserve signaling NaN
-        }
-        return uint16_t(u.int32 >> 16);
+        return u.int32;
     }
 
-    // Truncate instead of rounding, preserving SNaN
-    static __host__ __device__ uint16_t truncate_float_to_bfloat16(float f)
+    static __host__ __device__ float bits_to_float(uint32_t bits)
     {
         union
         {
-            float    fp32;
             uint32_t int32;
-        } u = {f};
-        return uint16_t(u.int32 >> 16) | (!(~u.int32 & 0x7f800000) && (u.int32 & 0xffff));
+            float    fp32;
+        } u = {bits};
+        return u.fp32;
+    }
+#endif
+
+    static __HIP_BFLOAT16_CONSTEXPR __host__ __device__ uint16_t float_to_bfloat16(float f)
+    {
+        return float_bits_to_bfloat16(float_to_bits(f));
+    }
+
+    // When the exponent bits are not all 1s, then the value is zero, normal,
+    // or subnormal. We round the bfloat16 mantissa up by adding 0x7FFF, plus
+    // 1 if the least significant bit of the bfloat16 mantissa is 1 (odd).
+    // This causes the bfloat16's mantissa to be incremented by 1 if the 16
+    // least significant bits of the float mantissa are greater than 0x8000,
+    // or if they are equal to 0x8000 and the least significant bit of the
+    // bfloat16 mantissa is 1 (odd). This causes it to be rounded to even when
+    // the lower 16 bits are exactly 0x8000. If the bfloat16 mantissa already
+    // has the value 0x7f, then incrementing it causes it to become 0x00 and
+    // the exponent is incremented by one, which is the next higher FP value
+    // to the unrounded bfloat16 value. When the bfloat16 value is subnormal
+    // with an exponent of 0x00 and a mantissa of 0x7F, it may be rounded up
+    // to a normal value with an exponent of 0x01 and a mantissa of 0x00.
+    // When the bfloat16 value has an exponent of 0xFE and a mantissa of 0x7F,
+    // incrementing it causes it to become an exponent of 0xFF and a mantissa
+    // of 0x00, which is Inf, the next higher value to the unrounded value.
+    //
+    // When all of the exponent bits are 1, the value is Inf or NaN.
+    // Inf is indicated by a zero mantissa. NaN is indicated by any nonzero
+    // mantissa bit. Quiet NaN is indicated by the most significant mantissa
+    // bit being 1. Signaling NaN is indicated by the most significant
+    // mantissa bit being 0 but some other bit(s) being 1. If any of the
+    // lower 16 bits of the mantissa are 1, we set the least significant bit
+    // of the bfloat16 mantissa, in order to preserve signaling NaN in case
+    // the bloat16's mantissa bits are all 0.
+    //
+    // This is a single expression, so that it is constexpr in C++11 too.
+    static constexpr __host__ __device__ uint16_t float_bits_to_bfloat16(uint32_t int32)
+    {
+        return uint16_t(((~int32 & 0x7f800000)
+                             ? int32 + 0x7fff + ((int32 >> 16) & 1) // Round to nearest even
+                             : (int32 & 0xffff) ? int32 | 0x10000 // Preserve signaling NaN
+                                                : int32)
+                        >> 16);
+    }
+
+    // Truncate instead of rounding, preserving SNaN
+    static __HIP_BFLOAT16_CONSTEXPR __host__ __device__ uint16_t truncate_float_to_bfloat16(float f)
+    {
+        return truncate_float_bits_to_bfloat16(float_to_bits(f));
+    }
+
+    static constexpr __host__ __device__ uint16_t truncate_float_bits_to_bfloat16(uint32_t int32)
+    {
+        return uint16_t(uint16_t(int32 >> 16) | (!(~int32 & 0x7f800000) && (int32 & 0xffff)));
     }
 };
 
@@ -173,86 +258,93 @@ inline std::ostream& operator<<(std::ostream& os, const hip_bfloat16& bf16)
 {
     return os << float(bf16);
 }
-inline __host__ __device__ hip_bfloat16 operator+(hip_bfloat16 a)
+inline constexpr __host__ __device__ hip_bfloat16 operator+(hip_bfloat16 a)
 {
     return a;
 }
-inline __host__ __device__ hip_bfloat16 operator-(hip_bfloat16 a)
+inline constexpr __host__ __device__ hip_bfloat16 operator-(hip_bfloat16 a)
 {
-    a.data ^= 0x8000;
-    return a;
+    return hip_bfloat16(uint16_t(a.data ^ 0x8000), hip_bfloat16::from_bits);
 }
-inline __host__ __device__ hip_bfloat16 operator+(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 operator+(hip_bfloat16 a,
+                                                                           hip_bfloat16 b)
 {
     return hip_bfloat16(float(a) + float(b));
 }
-inline __host__ __device__ hip_bfloat16 operator-(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 operator-(hip_bfloat16 a,
+                                                                           hip_bfloat16 b)
 {
     return hip_bfloat16(float(a) - float(b));
 }
-inline __host__ __device__ hip_bfloat16 operator*(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 operator*(hip_bfloat16 a,
+                                                                           hip_bfloat16 b)
 {
     return hip_bfloat16(float(a) * float(b));
 }
-inline __host__ __device__ hip_bfloat16 operator/(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ hip_bfloat16 operator/(hip_bfloat16 a,
+                                                                           hip_bfloat16 b)
 {
     return hip_bfloat16(float(a) / float(b));
 }
-inline __host__ __device__ bool operator<(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator<(hip_bfloat16 a, hip_bfloat16 b)
 {
     return float(a) < float(b);
 }
-inline __host__ __device__ bool operator==(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator==(hip_bfloat16 a, hip_bfloat16 b)
 {
     return float(a) == float(b);
 }
-inline __host__ __device__ bool operator>(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator>(hip_bfloat16 a, hip_bfloat16 b)
 {
     return b < a;
 }
-inline __host__ __device__ bool operator<=(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator<=(hip_bfloat16 a, hip_bfloat16 b)
 {
     return !(a > b);
 }
-inline __host__ __device__ bool operator!=(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator!=(hip_bfloat16 a, hip_bfloat16 b)
 {
     return !(a == b);
 }
-inline __host__ __device__ bool operator>=(hip_bfloat16 a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator>=(hip_bfloat16 a, hip_bfloat16 b)
 {
     return !(a < b);
 }
-inline __host__ __device__ hip_bfloat16& operator+=(hip_bfloat16& a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator+=(hip_bfloat16& a,
+                                                                               hip_bfloat16 b)
 {
     return a = a + b;
 }
-inline __host__ __device__ hip_bfloat16& operator-=(hip_bfloat16& a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator-=(hip_bfloat16& a,
+                                                                               hip_bfloat16 b)
 {
     return a = a - b;
 }
-inline __host__ __device__ hip_bfloat16& operator*=(hip_bfloat16& a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator*=(hip_bfloat16& a,
+                                                                               hip_bfloat16 b)
 {
     return a = a * b;
 }
-inline __host__ __device__ hip_bfloat16& operator/=(hip_bfloat16& a, hip_bfloat16 b)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator/=(hip_bfloat16& a,
+                                                                               hip_bfloat16 b)
 {
     return a = a / b;
 }
-inline __host__ __device__ hip_bfloat16& operator++(hip_bfloat16& a)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator++(hip_bfloat16& a)
 {
     return a += hip_bfloat16(1.0f);
 }
-inline __host__ __device__ hip_bfloat16& operator--(hip_bfloat16& a)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16& operator--(hip_bfloat16& a)
 {
     return a -= hip_bfloat16(1.0f);
 }
-inline __host__ __device__ hip_bfloat16 operator++(hip_bfloat16& a, int)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16 operator++(hip_bfloat16& a, int)
 {
     hip_bfloat16 orig = a;
     ++a;
     return orig;
 }
-inline __host__ __device__ hip_bfloat16 operator--(hip_bfloat16& a, int)
+inline __HIP_BFLOAT16_CONSTEXPR14 __host__ __device__ hip_bfloat16 operator--(hip_bfloat16& a, int)
 {
     hip_bfloat16 orig = a;
     --a;
@@ -275,6 +367,459 @@ namespace std
     }
 }
 
+// A pair of bfloat16 packed in 32 bits, e.g. two adjacent elements of a bfloat16 array, that is
+// loaded, stored and converted from and to float2 as a whole. Arithmetic widens both lanes to
+// float and rounds every result back to bfloat16, as hip_bfloat16 does.
+struct hip_bfloat162
+{
+    __HIP_BFLOAT162_ALIGN hip_bfloat16 x;
+    hip_bfloat16                       y;
+
+    __host__ __device__ hip_bfloat162() = default;
+
+    constexpr __host__ __device__ hip_bfloat162(hip_bfloat16 lo, hip_bfloat16 hi)
+        : x(lo)
+        , y(hi)
+    {
+    }
+
+    // round both lanes to nearest even
+    explicit __host__ __device__ hip_bfloat162(float2 f)
+        : x(f.x)
+        , y(f.y)
+    {
+    }
+
+    explicit __host__ __device__ hip_bfloat162(float2 f, hip_bfloat16::truncate_t)
+        : x(f.x, hip_bfloat16::truncate)
+        , y(f.y, hip_bfloat16::truncate)
+    {
+    }
+
+    __host__ __device__ operator float2() const
+    {
+        return make_float2(float(x), float(y));
+    }
+
+    static __host__ __device__ hip_bfloat162 round_to_bfloat162(float2 f)
+    {
+        return hip_bfloat162(f);
+    }
+
+    static __host__ __device__ hip_bfloat162 round_to_bfloat162(float2 f, hip_bfloat16::truncate_t)
+    {
+        return hip_bfloat162(f, hip_bfloat16::truncate);
+    }
+};
+
+typedef struct
+{
+    __HIP_BFLOAT162_ALIGN hip_bfloat16_public x;
+    hip_bfloat16_public                       y;
+} hip_bfloat162_public;
+
+static_assert(std::is_standard_layout<hip_bfloat162>{},
+              "hip_bfloat162 is not a standard layout type, and thus is "
+              "incompatible with C.");
+
+static_assert(std::is_trivial<hip_bfloat162>{},
+              "hip_bfloat162 is not a trivial type, and thus is "
+              "incompatible with C.");
+
+static_assert(sizeof(hip_bfloat162) == sizeof(hip_bfloat162_public)
+                  && alignof(hip_bfloat162) == alignof(hip_bfloat162_public)
+                  && offsetof(hip_bfloat162, x) == offsetof(hip_bfloat162_public, x)
+                  && offsetof(hip_bfloat162, y) == offsetof(hip_bfloat162_public, y),
+              "internal hip_bfloat162 does not match public hip_bfloat162");
+
+static_assert(sizeof(hip_bfloat162) == 4 && alignof(hip_bfloat162) == 4,
+              "hip_bfloat162 is not packed in 32 bits");
+
+inline std::ostream& operator<<(std::ostream& os, const hip_bfloat162& bf162)
+{
+    return os << '(' << bf162.x << ", " << bf162.y << ')';
+}
+inline constexpr __host__ __device__ hip_bfloat162 operator+(hip_bfloat162 a)
+{
+    return a;
+}
+inline constexpr __host__ __device__ hip_bfloat162 operator-(hip_bfloat162 a)
+{
+    return hip_bfloat162(-a.x, -a.y);
+}
+inline __host__ __device__ hip_bfloat162 operator+(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(make_float2(float(a.x) + float(b.x), float(a.y) + float(b.y)));
+}
+inline __host__ __device__ hip_bfloat162 operator-(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(make_float2(float(a.x) - float(b.x), float(a.y) - float(b.y)));
+}
+inline __host__ __device__ hip_bfloat162 operator*(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(make_float2(float(a.x) * float(b.x), float(a.y) * float(b.y)));
+}
+inline __host__ __device__ hip_bfloat162 operator/(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(make_float2(float(a.x) / float(b.x), float(a.y) / float(b.y)));
+}
+// a * b + c for both lanes, computed with fmaf in float and then rounded to bfloat16. The
+// product is exact in float, but the sum is rounded twice, to float and then to bfloat16.
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_fma(hip_bfloat162 a,
+                                                           hip_bfloat162 b,
+                                                           hip_bfloat162 c)
+{
+    return hip_bfloat162(make_float2(fmaf(float(a.x), float(b.x), float(c.x)),
+                                     fmaf(float(a.y), float(b.y), float(c.y))));
+}
+// true if both lanes are equal
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator==(hip_bfloat162 a,
+                                                                    hip_bfloat162 b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+inline __HIP_BFLOAT16_CONSTEXPR __host__ __device__ bool operator!=(hip_bfloat162 a,
+                                                                    hip_bfloat162 b)
+{
+    return !(a == b);
+}
+// Lane-wise comparisons: 1.0 in the lanes where the comparison is true, 0.0 in the others
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_eq(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x == b.x)), hip_bfloat16(float(a.y == b.y)));
+}
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_ne(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x != b.x)), hip_bfloat16(float(a.y != b.y)));
+}
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_lt(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x < b.x)), hip_bfloat16(float(a.y < b.y)));
+}
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_le(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x <= b.x)), hip_bfloat16(float(a.y <= b.y)));
+}
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_gt(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x > b.x)), hip_bfloat16(float(a.y > b.y)));
+}
+inline __host__ __device__ hip_bfloat162 hip_bfloat162_ge(hip_bfloat162 a, hip_bfloat162 b)
+{
+    return hip_bfloat162(hip_bfloat16(float(a.x >= b.x)), hip_bfloat16(float(a.y >= b.y)));
+}
+inline __host__ __device__ hip_bfloat162& operator+=(hip_bfloat162& a, hip_bfloat162 b)
+{
+    return a = a + b;
+}
+inline __host__ __device__ hip_bfloat162& operator-=(hip_bfloat162& a, hip_bfloat162 b)
+{
+    return a = a - b;
+}
+inline __host__ __device__ hip_bfloat162& operator*=(hip_bfloat162& a, hip_bfloat162 b)
+{
+    return a = a * b;
+}
+inline __host__ __device__ hip_bfloat162& operator/=(hip_bfloat162& a, hip_bfloat162 b)
+{
+    return a = a / b;
+}
+
 #endif // __cplusplus < 201103L || !defined(__HIPCC__)
 
+#if __cplusplus >= 201103L
+
+// Bulk host conversions between float and hip_bfloat16 arrays, e.g. to stage weights before a copy
+// to the device. They give the same results as converting every element with hip_bfloat16(float)
+// and float(hip_bfloat16), and use AVX2, AVX-512 or AVX512_BF16 when the CPU supports them.
+// They are declared in the device pass as well, which parses host code, with the scalar
+// conversions only. Define HIP_BFLOAT16_NO_SIMD to only build the scalar conversions.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(__HIP_DEVICE_COMPILE__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__)) && !defined(HIP_BFLOAT16_NO_SIMD)
+#define HIP_BFLOAT16_X86_SIMD 1
+#include <cpuid.h>
+#include <immintrin.h>
+// AVX512_BF16 intrinsics are available in clang 9 and gcc 10 onwards
+#if(defined(__clang__) && __clang_major__ >= 9) || (!defined(__clang__) && __GNUC__ >= 10)
+#define HIP_BFLOAT16_X86_AVX512BF16 1
+#endif
+#endif
+
+namespace hip_bfloat16_detail
+{
+    enum host_isa_t
+    {
+        host_isa_scalar,
+        host_isa_avx2,
+        host_isa_avx512,
+        host_isa_avx512bf16
+    };
+
+    // Round to nearest even, preserving signaling NaN, as hip_bfloat16(float) does
+    inline uint16_t float_bits_to_bfloat16(uint32_t u)
+    {
+        if(~u & 0x7f800000)
+            u += 0x7fff + ((u >> 16) & 1);
+        else if(u & 0xffff)
+            u |= 0x10000;
+        return uint16_t(u >> 16);
+    }
+
+    inline void from_float_n_scalar(uint16_t* dst, const float* src, size_t n)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            uint32_t u;
+            memcpy(&u, &src[i], sizeof(u));
+            dst[i] = float_bits_to_bfloat16(u);
+        }
+    }
+
+    inline void to_float_n_scalar(float* dst, const uint16_t* src, size_t n)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            uint32_t u = uint32_t(src[i]) << 16;
+            memcpy(&dst[i], &u, sizeof(u));
+        }
+    }
+
+#ifdef HIP_BFLOAT16_X86_SIMD
+    inline uint64_t xgetbv0()
+    {
+        uint32_t eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (uint64_t(edx) << 32) | eax;
+    }
+
+    // Best ISA supported by both the CPU and the OS, which must save the YMM/ZMM registers
+    inline host_isa_t detect_host_isa()
+    {
+        unsigned eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE))
+            return host_isa_scalar;
+        uint64_t xcr0 = xgetbv0();
+        if((xcr0 & 0x6) != 0x6 || __get_cpuid_max(0, nullptr) < 7)
+            return host_isa_scalar;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        bool avx2    = ebx & (1u << 5);
+        bool avx512f = ebx & (1u << 16);
+        if(!avx2)
+            return host_isa_scalar;
+        if(!avx512f || (xcr0 & 0xe6) != 0xe6)
+            return host_isa_avx2;
+        __cpuid_count(7, 1, eax, ebx, ecx, edx);
+#ifdef HIP_BFLOAT16_X86_AVX512BF16
+        if(eax & (1u << 5))
+            return host_isa_avx512bf16;
+#endif
+        return host_isa_avx512;
+    }
+
+    __attribute__((target("avx2"))) inline __m256i float_bits_to_bfloat16_avx2(__m256i u)
+    {
+        const __m256i exponent = _mm256_set1_epi32(0x7f800000);
+        __m256i       rounded  = _mm256_add_epi32(
+            u,
+            _mm256_add_epi32(_mm256_set1_epi32(0x7fff),
+                             _mm256_and_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(1))));
+        // Inf or NaN: keep the bits, setting the bfloat16 LSB if any of the lower 16 bits is set
+        __m256i special = _mm256_cmpeq_epi32(_mm256_and_si256(u, exponent), exponent);
+        __m256i low     = _mm256_and_si256(u, _mm256_set1_epi32(0xffff));
+        __m256i nan_bit = _mm256_andnot_si256(_mm256_cmpeq_epi32(low, _mm256_setzero_si256()),
+                                              _mm256_set1_epi32(0x10000));
+        __m256i result  = _mm256_blendv_epi8(rounded, _mm256_or_si256(u, nan_bit), special);
+        return _mm256_srli_epi32(result, 16);
+    }
+
+    __attribute__((target("avx2"))) inline void
+        from_float_n_avx2(uint16_t* dst, const float* src, size_t n)
+    {
+        size_t i = 0;
+        for(; i + 16 <= n; i += 16)
+        {
+            __m256i lo = float_bits_to_bfloat16_avx2(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+            __m256i hi = float_bits_to_bfloat16_avx2(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8)));
+            // packus works within 128-bit lanes, so restore the order of the 64-bit quarters
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        from_float_n_scalar(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) inline void
+        to_float_n_avx2(float* dst, const uint16_t* src, size_t n)
+    {
+        size_t i = 0;
+        for(; i + 8 <= n; i += 8)
+        {
+            __m256i u = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_slli_epi32(u, 16));
+        }
+        to_float_n_scalar(dst + i, src + i, n - i);
+    }
+
+    // The AVX-512 shifts and conversions are used in their zero-masked forms with every lane
+    // set, which are the same instructions: the plain forms start from _mm512_undefined_epi32(),
+    // which GCC reports with -Wmaybe-uninitialized.
+    const __mmask16 all_lanes = 0xffff;
+
+    __attribute__((target("avx512f"))) inline __m512i float_bits_to_bfloat16_avx512(__m512i u)
+    {
+        const __m512i exponent = _mm512_set1_epi32(0x7f800000);
+        __m512i       low_bit
+            = _mm512_and_si512(_mm512_maskz_srli_epi32(all_lanes, u, 16), _mm512_set1_epi32(1));
+        __m512i rounded
+            = _mm512_add_epi32(u, _mm512_add_epi32(_mm512_set1_epi32(0x7fff), low_bit));
+        __mmask16 special = _mm512_cmpeq_epi32_mask(_mm512_and_si512(u, exponent), exponent);
+        __mmask16 nan     = _mm512_test_epi32_mask(u, _mm512_set1_epi32(0xffff));
+        __m512i   result  = _mm512_mask_blend_epi32(special, rounded, u);
+        result = _mm512_mask_or_epi32(result, special & nan, result, _mm512_set1_epi32(0x10000));
+        return _mm512_maskz_srli_epi32(all_lanes, result, 16);
+    }
+
+    __attribute__((target("avx512f"))) inline void
+        from_float_n_avx512(uint16_t* dst, const float* src, size_t n)
+    {
+        size_t i = 0;
+        for(; i + 16 <= n; i += 16)
+        {
+            __m512i u = _mm512_loadu_si512(src + i);
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(dst + i),
+                _mm512_maskz_cvtepi32_epi16(all_lanes, float_bits_to_bfloat16_avx512(u)));
+        }
+        from_float_n_scalar(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx512f"))) inline void
+        to_float_n_avx512(float* dst, const uint16_t* src, size_t n)
+    {
+        size_t i = 0;
+        for(; i + 16 <= n; i += 16)
+        {
+            __m512i u = _mm512_maskz_cvtepu16_epi32(
+                all_lanes, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+            _mm512_storeu_si512(dst + i, _mm512_maskz_slli_epi32(all_lanes, u, 16));
+        }
+        to_float_n_scalar(dst + i, src + i, n - i);
+    }
+
+#ifdef HIP_BFLOAT16_X86_AVX512BF16
+    // VCVTNE2PS2BF16 rounds to nearest even, but treats subnormal inputs as zero and quiets NaNs,
+    // so vectors with any of those take the integer path instead.
+    __attribute__((target("avx512f,avx512bf16"))) inline void
+        from_float_n_avx512bf16(uint16_t* dst, const float* src, size_t n)
+    {
+        const __m512i abs_mask        = _mm512_set1_epi32(0x7fffffff);
+        const __m512i one             = _mm512_set1_epi32(1);
+        const __m512i subnormal_limit = _mm512_set1_epi32(0x7fffff);
+        const __m512i inf             = _mm512_set1_epi32(0x7f800000);
+        size_t        i               = 0;
+        for(; i + 32 <= n; i += 32)
+        {
+            __m512i lo     = _mm512_loadu_si512(src + i);
+            __m512i hi     = _mm512_loadu_si512(src + i + 16);
+            __m512i lo_abs = _mm512_and_si512(lo, abs_mask);
+            __m512i hi_abs = _mm512_and_si512(hi, abs_mask);
+            // abs - 1 < 0x7fffff for subnormals, abs > 0x7f800000 for NaNs
+            __mmask16 exact
+                = _mm512_cmplt_epu32_mask(_mm512_sub_epi32(lo_abs, one), subnormal_limit)
+                  | _mm512_cmpgt_epu32_mask(lo_abs, inf)
+                  | _mm512_cmplt_epu32_mask(_mm512_sub_epi32(hi_abs, one), subnormal_limit)
+                  | _mm512_cmpgt_epu32_mask(hi_abs, inf);
+            if(!exact)
+            {
+                __m512bh packed = _mm512_cvtne2ps_pbh(_mm512_castsi512_ps(hi),
+                                                      _mm512_castsi512_ps(lo));
+                _mm512_storeu_si512(dst + i, (__m512i)packed);
+            }
+            else
+            {
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i*>(dst + i),
+                    _mm512_maskz_cvtepi32_epi16(all_lanes, float_bits_to_bfloat16_avx512(lo)));
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i*>(dst + i + 16),
+                    _mm512_maskz_cvtepi32_epi16(all_lanes, float_bits_to_bfloat16_avx512(hi)));
+            }
+        }
+        from_float_n_avx512(dst + i, src + i, n - i);
+    }
+#endif // HIP_BFLOAT16_X86_AVX512BF16
+
+    inline host_isa_t host_isa()
+    {
+        static const host_isa_t isa = detect_host_isa();
+        return isa;
+    }
+#else // HIP_BFLOAT16_X86_SIMD
+    inline host_isa_t host_isa()
+    {
+        return host_isa_scalar;
+    }
+#endif // HIP_BFLOAT16_X86_SIMD
+
+    inline void from_float_n(uint16_t* dst, const float* src, size_t n, host_isa_t isa)
+    {
+        switch(isa)
+        {
+#ifdef HIP_BFLOAT16_X86_SIMD
+#ifdef HIP_BFLOAT16_X86_AVX512BF16
+        case host_isa_avx512bf16:
+            return from_float_n_avx512bf16(dst, src, n);
+#endif
+        case host_isa_avx512:
+            return from_float_n_avx512(dst, src, n);
+        case host_isa_avx2:
+            return from_float_n_avx2(dst, src, n);
+#endif
+        default:
+            return from_float_n_scalar(dst, src, n);
+        }
+    }
+
+    inline void to_float_n(float* dst, const uint16_t* src, size_t n, host_isa_t isa)
+    {
+        switch(isa)
+        {
+#ifdef HIP_BFLOAT16_X86_SIMD
+        case host_isa_avx512bf16:
+        case host_isa_avx512:
+            return to_float_n_avx512(dst, src, n);
+        case host_isa_avx2:
+            return to_float_n_avx2(dst, src, n);
+#endif
+        default:
+            return to_float_n_scalar(dst, src, n);
+        }
+    }
+} // namespace hip_bfloat16_detail
+
+static_assert(sizeof(hip_bfloat16) == sizeof(uint16_t), "hip_bfloat16 is not 16 bits");
+
+// Convert n floats to hip_bfloat16, rounding to nearest even like hip_bfloat16(float)
+inline void hip_bfloat16_from_float_n(hip_bfloat16* dst, const float* src, size_t n)
+{
+    hip_bfloat16_detail::from_float_n(
+        reinterpret_cast<uint16_t*>(dst), src, n, hip_bfloat16_detail::host_isa());
+}
+
+// Convert n hip_bfloat16 to float
+inline void hip_bfloat16_to_float_n(float* dst, const hip_bfloat16* src, size_t n)
+{
+    hip_bfloat16_detail::to_float_n(
+        dst, reinterpret_cast<const uint16_t*>(src), n, hip_bfloat16_detail::host_isa());
+}
+
+#endif // __cplusplus >= 201103L
+
 #endif // _HIP_BFLOAT16_H_
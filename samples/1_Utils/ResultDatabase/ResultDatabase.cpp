@@ -0,0 +1,757 @@
+#include "ResultDatabase.h"
+
+#include <cfloat>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <ctime>
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/utsname.h>
+#endif
+
+using namespace std;
+
+#define SORT_RETAIN_ATTS_ORDER 1
+
+
+const double ResultStatistics::RelativeError = 0.005;
+
+// Each bucket is wider than the previous one by growth, so that the middle
+// of a bucket is within RelativeError of every value in it.
+static const double growth = (1 + ResultStatistics::RelativeError) /
+                            (1 - ResultStatistics::RelativeError);
+static const double logGrowth = log(growth);
+// Smaller magnitudes are counted as zeros
+static const double minBinned = 1e-300;
+
+ResultStatistics::ResultStatistics() { Clear(); }
+
+void ResultStatistics::Clear() {
+    count = 0;
+    mean = 0;
+    m2 = 0;
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    binned = false;
+    zeros = 0;
+    positive.clear();
+    negative.clear();
+}
+
+void ResultStatistics::Add(double v) {
+    count++;
+    double delta = v - mean;
+    mean += delta / count;
+    m2 += delta * (v - mean);
+    if (v < min) min = v;
+    if (v > max) max = v;
+    if (binned) Bin(v);
+}
+
+void ResultStatistics::Bin(double v) {
+    double magnitude = fabs(v);
+    if (magnitude < minBinned) {
+        zeros++;
+        return;
+    }
+    int bucket = int(ceil(log(magnitude) / logGrowth));
+    if (v > 0)
+        positive[bucket]++;
+    else
+        negative[bucket]++;
+}
+
+double ResultStatistics::BucketValue(int bucket) const {
+    return 2 * pow(growth, bucket) / (growth + 1);
+}
+
+void ResultStatistics::StartHistogram(const vector<double>& values) {
+    if (binned) return;
+    binned = true;
+    for (size_t i = 0; i < values.size(); i++) Bin(values[i]);
+}
+
+// ****************************************************************************
+//  Method:  ResultStatistics::Merge
+//
+//  Purpose:
+//    Adds the statistics of another set of values, with the pairwise update
+//    of the moments of Chan et al.  The histograms are merged bucket by
+//    bucket; values the other side did not bin are only in its moments.
+//
+//  Arguments:
+//    rhs        the statistics to add
+//
+// ****************************************************************************
+void ResultStatistics::Merge(const ResultStatistics& rhs) {
+    if (rhs.count == 0) return;
+    uint64_t n = count + rhs.count;
+    double delta = rhs.mean - mean;
+    mean += delta * rhs.count / n;
+    m2 += rhs.m2 + delta * delta * (double(count) * rhs.count / n);
+    count = n;
+    if (rhs.min < min) min = rhs.min;
+    if (rhs.max > max) max = rhs.max;
+
+    binned = binned || rhs.binned;
+    zeros += rhs.zeros;
+    std::map<int, uint64_t>::const_iterator it;
+    for (it = rhs.positive.begin(); it != rhs.positive.end(); ++it) positive[it->first] += it->second;
+    for (it = rhs.negative.begin(); it != rhs.negative.end(); ++it) negative[it->first] += it->second;
+}
+
+double ResultStatistics::GetMean() const {
+    if (count == 0) return std::numeric_limits<double>::quiet_NaN();
+    return mean;
+}
+
+double ResultStatistics::GetStdDev() const {
+    if (count == 0) return std::numeric_limits<double>::quiet_NaN();
+    if (mean == FLT_MAX) return FLT_MAX;
+    return sqrt(m2 / count);
+}
+
+double ResultStatistics::GetPercentile(double q) const {
+    if (count == 0) return FLT_MAX;
+    if (q <= 0) return min;
+    if (q >= 100) return max;
+
+    // The bucket holding the value of rank q, from the most negative value up
+    uint64_t rank = uint64_t(q / 100. * (count - 1));
+    uint64_t seen = 0;
+    double r = max;
+    bool found = false;
+    std::map<int, uint64_t>::const_reverse_iterator nit;
+    for (nit = negative.rbegin(); !found && nit != negative.rend(); ++nit) {
+        seen += nit->second;
+        if (seen > rank) {
+            r = -BucketValue(nit->first);
+            found = true;
+        }
+    }
+    if (!found) {
+        seen += zeros;
+        if (seen > rank) {
+            r = 0;
+            found = true;
+        }
+    }
+    std::map<int, uint64_t>::const_iterator pit;
+    for (pit = positive.begin(); !found && pit != positive.end(); ++pit) {
+        seen += pit->second;
+        if (seen > rank) {
+            r = BucketValue(pit->first);
+            found = true;
+        }
+    }
+    return std::min(std::max(r, min), max);
+}
+
+
+bool ResultDatabase::Result::operator<(const Result& rhs) const {
+    if (test < rhs.test) return true;
+    if (test > rhs.test) return false;
+#if (SORT_RETAIN_ATTS_ORDER == 0)
+    // For ties, sort by the value of the attribute:
+    if (atts < rhs.atts) return true;
+    if (atts > rhs.atts) return false;
+#endif
+    return false;  // less-operator returns false on equal
+}
+
+void ResultDatabase::Result::Add(double v, size_t sampleLimit) {
+    stats.Add(v);
+    if (stats.HasHistogram()) return;
+    value.push_back(v);
+    sorted.clear();
+    if (value.size() > sampleLimit) DropValues();
+}
+
+// Moves the values into the histogram, and stops keeping them
+void ResultDatabase::Result::DropValues() {
+    stats.StartHistogram(value);
+    vector<double>().swap(value);
+    vector<double>().swap(sorted);
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::Result::Merge
+//
+//  Purpose:
+//    Adds the values of another result for the same test.  The raw values
+//    are appended while both sides have them and the total is within the
+//    sample limit, otherwise the histograms are merged.
+//
+//  Arguments:
+//    rhs          the result to add
+//    sampleLimit  the raw values to keep at most
+//
+// ****************************************************************************
+void ResultDatabase::Result::Merge(const Result& rhs, size_t sampleLimit) {
+    if (rhs.unit != unit) throw "Internal error: mixed units";
+    if (HasAllValues() && rhs.HasAllValues() && value.size() + rhs.value.size() <= sampleLimit) {
+        value.insert(value.end(), rhs.value.begin(), rhs.value.end());
+        sorted.clear();
+        stats.Merge(rhs.stats);
+        return;
+    }
+    ResultStatistics other(rhs.stats);
+    if (rhs.HasAllValues()) other.StartHistogram(rhs.value);
+    if (HasAllValues()) DropValues();
+    stats.Merge(other);
+}
+
+const vector<double>& ResultDatabase::Result::Sorted() const {
+    if (sorted.size() != value.size()) {
+        sorted = value;
+        sort(sorted.begin(), sorted.end());
+    }
+    return sorted;
+}
+
+double ResultDatabase::Result::GetMin() const { return stats.GetMin(); }
+
+double ResultDatabase::Result::GetMax() const { return stats.GetMax(); }
+
+double ResultDatabase::Result::GetMedian() const { return GetPercentile(50); }
+
+// The values are sorted once for all the percentiles of a result
+double ResultDatabase::Result::GetPercentile(double q) const {
+    if (!HasAllValues()) return stats.GetPercentile(q);
+
+    int n = value.size();
+    if (n == 0) return FLT_MAX;
+    const vector<double>& s = Sorted();
+    if (n == 1) return s[0];
+
+    if (q <= 0) return s[0];
+    if (q >= 100) return s[n - 1];
+
+    if (n == 2) return (s[0] * (1 - q / 100.) + s[1] * (q / 100.));
+
+    double index = ((n + 1.) * q / 100.) - 1;
+    if (index <= 0) return s[0];
+    if (index >= n - 1) return s[n - 1];
+
+    int index_lo = int(index);
+    double frac = index - index_lo;
+    if (frac == 0) return s[index_lo];
+
+    double lo = s[index_lo];
+    double hi = s[index_lo + 1];
+    return lo + (hi - lo) * frac;
+}
+
+double ResultDatabase::Result::GetMean() const { return stats.GetMean(); }
+
+double ResultDatabase::Result::GetStdDev() const { return stats.GetStdDev(); }
+
+ResultDatabase::Summary ResultDatabase::Result::GetSummary() const {
+    Summary s;
+    s.median = GetMedian();
+    s.mean = stats.GetMean();
+    s.stddev = stats.GetStdDev();
+    s.min = stats.GetMin();
+    s.max = stats.GetMax();
+    return s;
+}
+
+
+void ResultDatabase::AddResults(const string& test, const string& atts, const string& unit,
+                                const vector<double>& values) {
+    for (int i = 0; i < values.size(); i++) {
+        AddResult(test, atts, unit, values[i]);
+    }
+}
+
+static string RemoveAllButLeadingSpaces(const string& a) {
+    string b;
+    int n = a.length();
+    int i = 0;
+    while (i < n && a[i] == ' ') {
+        b += a[i];
+        ++i;
+    }
+    for (; i < n; i++) {
+        if (a[i] != ' ' && a[i] != '\t') b += a[i];
+    }
+    return b;
+}
+
+void ResultDatabase::AddResult(const string& test_orig, const string& atts_orig,
+                               const string& unit_orig, double value) {
+    string test = RemoveAllButLeadingSpaces(test_orig);
+    string atts = RemoveAllButLeadingSpaces(atts_orig);
+    string unit = RemoveAllButLeadingSpaces(unit_orig);
+    FindResult(test, atts, unit).Add(value, sampleLimit);
+}
+
+ResultDatabase::Result& ResultDatabase::FindResult(const string& test, const string& atts,
+                                                   const string& unit) {
+    std::pair<string, string> key(test, atts);
+    std::map<std::pair<string, string>, size_t>::iterator it = index.find(key);
+    if (it != index.end()) {
+        Result& r = results[it->second];
+        if (r.unit != unit) throw "Internal error: mixed units";
+        return r;
+    }
+
+    Result r;
+    r.test = test;
+    r.atts = atts;
+    r.unit = unit;
+    index[key] = results.size();
+    results.push_back(r);
+    return results.back();
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::Merge
+//
+//  Purpose:
+//    Adds all the results of another database, e.g. one filled by another
+//    thread.  Results with the same test and attributes are merged, and
+//    metadata keys this database does not have are copied.
+//
+//  Arguments:
+//    rhs        the database to add
+//
+// ****************************************************************************
+void ResultDatabase::Merge(const ResultDatabase& rhs) {
+    metadata.insert(rhs.metadata.begin(), rhs.metadata.end());
+    for (size_t i = 0; i < rhs.results.size(); i++) {
+        const Result& r = rhs.results[i];
+        FindResult(r.test, r.atts, r.unit).Merge(r, sampleLimit);
+    }
+}
+
+// The results ordered for printing; pointers, to not copy the values
+vector<const ResultDatabase::Result*> ResultDatabase::SortedResults() const {
+    vector<const Result*> sorted;
+    for (size_t i = 0; i < results.size(); i++) sorted.push_back(&results[i]);
+    stable_sort(sorted.begin(), sorted.end(),
+                [](const Result* a, const Result* b) { return *a < *b; });
+    return sorted;
+}
+
+static void PrintValue(ostream& out, double value, const char* separator) {
+    if (value == FLT_MAX)
+        out << "N/A" << separator;
+    else
+        out << value << separator;
+}
+
+static void PrintSummary(ostream& out, const ResultDatabase::Summary& s, const char* separator) {
+    PrintValue(out, s.median, separator);
+    PrintValue(out, s.mean, separator);
+    PrintValue(out, s.stddev, separator);
+    PrintValue(out, s.min, separator);
+    PrintValue(out, s.max, separator);
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::DumpDetailed
+//
+//  Purpose:
+//    Writes the full results, including all trials.
+//
+//  Arguments:
+//    out        where to print
+//
+//  Programmer:  Jeremy Meredith
+//  Creation:    August 14, 2009
+//
+//  Modifications:
+//    Jeremy Meredith, Wed Nov 10 14:25:17 EST 2010
+//    Renamed to DumpDetailed to make room for a DumpSummary.
+//
+//    Jeremy Meredith, Thu Nov 11 11:39:57 EST 2010
+//    Added note about (*) missing value tag.
+//
+//    Jeremy Meredith, Tue Nov 23 13:57:02 EST 2010
+//    Changed note about missing values to be worded a little better.
+//
+// ****************************************************************************
+void ResultDatabase::DumpDetailed(ostream& out) {
+    vector<const Result*> sorted = SortedResults();
+
+    const int testNameW = 24;
+    const int attW = 12;
+    const int fieldW = 11;
+    out << std::fixed << right << std::setprecision(4);
+
+    int maxtrials = 1;
+    for (int i = 0; i < sorted.size(); i++) {
+        if (sorted[i]->value.size() > maxtrials) maxtrials = sorted[i]->value.size();
+    }
+
+    // TODO: in big parallel runs, the "trials" are the procs
+    // and we really don't want to print them all out....
+    out << setw(testNameW) << "test\t" << setw(attW) << "atts\t" << setw(fieldW) << "median\t"
+        << "mean\t"
+        << "stddev\t"
+        << "min\t"
+        << "max\t";
+    for (int i = 0; i < maxtrials; i++) out << "trial" << i << "\t";
+    out << endl;
+
+    for (int i = 0; i < sorted.size(); i++) {
+        const Result& r = *sorted[i];
+        out << setw(testNameW) << r.test + "\t";
+        out << setw(attW) << r.atts + "\t";
+        out << setw(fieldW) << r.unit + "\t";
+        PrintSummary(out, r.GetSummary(), "\t");
+        for (int j = 0; j < r.value.size(); j++) PrintValue(out, r.value[j], "\t");
+
+        out << endl;
+    }
+    out << endl
+        << "Note: Any results marked with (*) had missing values." << endl
+        << "      This can occur on systems with a mixture of" << endl
+        << "      device types or architectural capabilities." << endl;
+}
+
+
+// ****************************************************************************
+//  Method:  ResultDatabase::DumpDetailed
+//
+//  Purpose:
+//    Writes the summary results (min/max/stddev/med/mean), but not
+//    every individual trial.
+//
+//  Arguments:
+//    out        where to print
+//
+//  Programmer:  Jeremy Meredith
+//  Creation:    November 10, 2010
+//
+//  Modifications:
+//    Jeremy Meredith, Thu Nov 11 11:39:57 EST 2010
+//    Added note about (*) missing value tag.
+//
+// ****************************************************************************
+void ResultDatabase::DumpSummary(ostream& out) {
+    vector<const Result*> sorted = SortedResults();
+
+    const int testNameW = 24;
+    const int attW = 12;
+    const int fieldW = 9;
+    out << std::fixed << right << std::setprecision(4);
+
+    // TODO: in big parallel runs, the "trials" are the procs
+    // and we really don't want to print them all out....
+    out << setw(testNameW) << "test\t" << setw(attW) << "atts\t" << setw(fieldW) << "units\t"
+        << "median\t"
+        << "mean\t"
+        << "stddev\t"
+        << "min\t"
+        << "max\t";
+    out << endl;
+
+    for (int i = 0; i < sorted.size(); i++) {
+        const Result& r = *sorted[i];
+        out << setw(testNameW) << r.test + "\t";
+        out << setw(attW) << r.atts + "\t";
+        out << setw(fieldW) << r.unit + "\t";
+        PrintSummary(out, r.GetSummary(), "\t");
+
+        out << endl;
+    }
+    out << endl
+        << "Note: results marked with (*) had missing values such as" << endl
+        << "might occur with a mixture of architectural capabilities." << endl;
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::ClearAllResults
+//
+//  Purpose:
+//    Clears all existing results from the ResultDatabase; used for multiple passes
+//    of the same test or multiple tests.
+//
+//  Arguments:
+//
+//  Programmer:  Jeffrey Young
+//  Creation:    September 10th, 2014
+//
+//  Modifications:
+//
+//
+// ****************************************************************************
+void ResultDatabase::ClearAllResults() {
+    results.clear();
+    index.clear();
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::DumpCsv
+//
+//  Purpose:
+//    Writes either detailed or summary results (min/max/stddev/med/mean), but not
+//    every individual trial.
+//
+//  Arguments:
+//    out        file to print CSV results
+//
+//  Programmer:  Jeffrey Young
+//  Creation:    August 28th, 2014
+//
+//  Modifications:
+//
+// ****************************************************************************
+void ResultDatabase::DumpCsv(string fileName) {
+    bool emptyFile;
+    vector<const Result*> sorted = SortedResults();
+
+    // Check to see if the file is empty - if so, add the headers
+    emptyFile = this->IsFileEmpty(fileName);
+
+    // Open file and append by default
+    ofstream out;
+    out.open(fileName.c_str(), std::ofstream::out | std::ofstream::app);
+
+    // Add headers only for empty files
+    if (emptyFile) {
+        // TODO: in big parallel runs, the "trials" are the procs
+        // and we really don't want to print them all out....
+        out << "test, "
+            << "atts, "
+            << "units, "
+            << "median, "
+            << "mean, "
+            << "stddev, "
+            << "min, "
+            << "max, ";
+        out << endl;
+    }
+
+    for (int i = 0; i < sorted.size(); i++) {
+        const Result& r = *sorted[i];
+        out << r.test << ", ";
+        out << r.atts << ", ";
+        out << r.unit << ", ";
+        PrintSummary(out, r.GetSummary(), ", ");
+
+        out << endl;
+    }
+    out << endl;
+
+    out.close();
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::IsFileEmpty
+//
+//  Purpose:
+//    Returns whether a file is empty - used as a helper for CSV printing
+//
+//  Arguments:
+//    file  The input file to check for emptiness
+//
+//  Programmer:  Jeffrey Young
+//  Creation:    August 28th, 2014
+//
+//  Modifications:
+//
+// ****************************************************************************
+
+bool ResultDatabase::IsFileEmpty(string fileName) {
+    bool fileEmpty;
+
+    ifstream file(fileName.c_str());
+
+    // If the file doesn't exist it is by definition empty
+    if (!file.good()) {
+        return true;
+    } else {
+        fileEmpty = (bool)(file.peek() == ifstream::traits_type::eof());
+        file.close();
+
+        return fileEmpty;
+    }
+
+    // Otherwise, return false
+    return false;
+}
+
+
+// ****************************************************************************
+//  Method:  ResultDatabase::GetResultsForTest
+//
+//  Purpose:
+//    Returns a vector of results for just one test name.
+//
+//  Arguments:
+//    test       the name of the test results to search for
+//
+//  Programmer:  Jeremy Meredith
+//  Creation:    December  3, 2010
+//
+//  Modifications:
+//
+// ****************************************************************************
+vector<ResultDatabase::Result> ResultDatabase::GetResultsForTest(const string& test) {
+    // get only the given test results
+    vector<Result> retval;
+    for (int i = 0; i < results.size(); i++) {
+        Result& r = results[i];
+        if (r.test == test) retval.push_back(r);
+    }
+    return retval;
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::GetResults
+//
+//  Purpose:
+//    Returns all the results.
+//
+//  Arguments:
+//
+//  Programmer:  Jeremy Meredith
+//  Creation:    December  3, 2010
+//
+//  Modifications:
+//
+// ****************************************************************************
+const vector<ResultDatabase::Result>& ResultDatabase::GetResults() const { return results; }
+
+// ****************************************************************************
+//  Method:  ResultDatabase::SetMetadata
+//
+//  Purpose:
+//    Records a property of the run, e.g. the device or driver version, that
+//    DumpJson writes with the results.
+//
+//  Arguments:
+//    key        the name of the property
+//    value      its value
+//
+// ****************************************************************************
+void ResultDatabase::SetMetadata(const string& key, const string& value) {
+    metadata[key] = value;
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::AddHostMetadata
+//
+//  Purpose:
+//    Records the host the run is on: its name, OS, architecture and CPU, and
+//    the date of the run.  Called once per run, before or after the results.
+//
+// ****************************************************************************
+void ResultDatabase::AddHostMetadata() {
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    SetMetadata("date", date);
+
+#if !defined(_WIN32)
+    char host[256];
+    if (gethostname(host, sizeof(host)) == 0) {
+        host[sizeof(host) - 1] = 0;
+        SetMetadata("host", host);
+    }
+    struct utsname name;
+    if (uname(&name) == 0) {
+        SetMetadata("os", string(name.sysname) + " " + name.release);
+        SetMetadata("arch", name.machine);
+    }
+    ifstream cpuinfo("/proc/cpuinfo");
+    string line;
+    while (getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t start = line.find_first_not_of(" \t", line.find(':') + 1);
+            if (start != string::npos) SetMetadata("cpu", line.substr(start));
+            break;
+        }
+    }
+#endif
+}
+
+static string JsonString(const string& s) {
+    std::ostringstream out;
+    out << '"';
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+        else
+            out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+// Missing values (FLT_MAX) and the NaN of empty statistics are written as null
+static string JsonNumber(double value) {
+    if (value == FLT_MAX || value != value || fabs(value) > DBL_MAX) return "null";
+    std::ostringstream out;
+    out << std::setprecision(17) << value;
+    return out.str();
+}
+
+// ****************************************************************************
+//  Method:  ResultDatabase::DumpJson
+//
+//  Purpose:
+//    Writes the metadata and all the results, with their statistics and raw
+//    values, as one JSON object:
+//      { "schema": "resultdb", "version": 1,
+//        "metadata": { "host": ..., ... },
+//        "results": [ { "test", "atts", "unit", "count",
+//                       "stats": { "median", "mean", "stddev", "min", "max",
+//                                  "p90", "p99", "p999" },
+//                       "samples": [ ... ] }, ... ] }
+//    "samples" is empty for results past the sample limit, whose percentiles
+//    come from the histogram.
+//
+//  Arguments:
+//    out        where to print
+//
+// ****************************************************************************
+void ResultDatabase::DumpJson(ostream& out) {
+    vector<const Result*> sorted = SortedResults();
+
+    out << "{\n";
+    out << "  \"schema\": \"resultdb\",\n";
+    out << "  \"version\": " << JsonVersion << ",\n";
+    out << "  \"metadata\": {";
+    std::map<string, string>::const_iterator it;
+    for (it = metadata.begin(); it != metadata.end(); ++it) {
+        out << (it == metadata.begin() ? "\n" : ",\n");
+        out << "    " << JsonString(it->first) << ": " << JsonString(it->second);
+    }
+    out << (metadata.empty() ? "},\n" : "\n  },\n");
+
+    out << "  \"results\": [";
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const Result& r = *sorted[i];
+        Summary s = r.GetSummary();
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\n";
+        out << "      \"test\": " << JsonString(r.test) << ",\n";
+        out << "      \"atts\": " << JsonString(r.atts) << ",\n";
+        out << "      \"unit\": " << JsonString(r.unit) << ",\n";
+        out << "      \"count\": " << r.stats.GetCount() << ",\n";
+        out << "      \"stats\": {\"median\": " << JsonNumber(s.median)
+            << ", \"mean\": " << JsonNumber(s.mean) << ", \"stddev\": " << JsonNumber(s.stddev)
+            << ", \"min\": " << JsonNumber(s.min) << ", \"max\": " << JsonNumber(s.max)
+            << ", \"p90\": " << JsonNumber(r.GetPercentile(90))
+            << ", \"p99\": " << JsonNumber(r.GetPercentile(99))
+            << ", \"p999\": " << JsonNumber(r.GetPercentile(99.9)) << "},\n";
+        out << "      \"samples\": [";
+        for (size_t j = 0; j < r.value.size(); j++) {
+            out << (j == 0 ? "" : ", ") << JsonNumber(r.value[j]);
+        }
+        out << "]\n";
+        out << "    }";
+    }
+    out << (sorted.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
@@ -0,0 +1,189 @@
+#ifndef RESULT_DATABASE_H
+#define RESULT_DATABASE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <iostream>
+#include <fstream>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+using std::ifstream;
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::vector;
+
+
+// ****************************************************************************
+// Class:  ResultStatistics
+//
+// Purpose:
+//   Streaming statistics of one result.  The count, min, max, mean and
+//   variance are updated for every value with Welford's method.  Once the
+//   raw values are no longer kept, percentiles come from a histogram with
+//   logarithmic buckets, whose estimates are within RelativeError of an
+//   actual value.  Both the moments and the histogram can be merged, so
+//   statistics gathered per thread or per run can be combined.
+//
+// ****************************************************************************
+class ResultStatistics {
+   public:
+    static const double RelativeError;
+
+    ResultStatistics();
+
+    void Add(double v);
+    void Merge(const ResultStatistics& rhs);
+    void Clear();
+
+    // Starts the histogram with the values added so far, which the caller
+    // kept; every later value is binned as well.
+    void StartHistogram(const vector<double>& values);
+    bool HasHistogram() const { return binned; }
+
+    uint64_t GetCount() const { return count; }
+    double GetMin() const { return min; }
+    double GetMax() const { return max; }
+    double GetMean() const;
+    double GetStdDev() const;
+    double GetPercentile(double q) const;
+
+   private:
+    void Bin(double v);
+    double BucketValue(int bucket) const;
+
+    uint64_t count;
+    double mean;
+    double m2;
+    double min;
+    double max;
+
+    bool binned;
+    uint64_t zeros;
+    std::map<int, uint64_t> positive;  // bucket of v -> number of values
+    std::map<int, uint64_t> negative;  // bucket of -v -> number of values
+};
+
+
+// ****************************************************************************
+// Class:  ResultDatabase
+//
+// Purpose:
+//   Track numerical results as they are generated.
+//   Print statistics of raw results.
+//
+// Programmer:  Jeremy Meredith
+// Creation:    June 12, 2009
+//
+// Modifications:
+//    Jeremy Meredith, Wed Nov 10 14:20:47 EST 2010
+//    Split timing reports into detailed and summary.  E.g. for serial code,
+//    we might report all trial values, but skip them in parallel.
+//
+//    Jeremy Meredith, Thu Nov 11 11:40:18 EST 2010
+//    Added check for missing value tag.
+//
+//    Jeremy Meredith, Mon Nov 22 13:37:10 EST 2010
+//    Added percentile statistic.
+//
+//    Jeremy Meredith, Fri Dec  3 16:30:31 EST 2010
+//    Added a method to extract a subset of results based on test name.  Also,
+//    the Result class is now public, so that clients can use them directly.
+//    Added a GetResults method as well, and made several functions const.
+//
+//    Statistics are kept as the values are added, and the raw values of a
+//    result are dropped past the sample limit, so long latency runs use a
+//    bounded amount of memory.  Databases can be merged.
+//
+//    Added run metadata and JSON output, which resultdb-compare reads.
+//
+// ****************************************************************************
+class ResultDatabase {
+   public:
+    // Raw values kept per result, before falling back to the histogram
+    static const size_t DefaultSampleLimit = 1 << 16;
+    // Version of the JSON output, changed when fields change meaning
+    static const int JsonVersion = 1;
+
+    //
+    // The summary columns of a result.
+    //
+    struct Summary {
+        double median;
+        double mean;
+        double stddev;
+        double min;
+        double max;
+    };
+
+    //
+    // A performance result for a single SHOC benchmark run.
+    //
+    struct Result {
+        string test;           // e.g. "readback"
+        string atts;           // e.g. "pagelocked 4k^2"
+        string unit;           // e.g. "MB/sec"
+        vector<double> value;  // e.g. "837.14", empty past the sample limit
+        ResultStatistics stats;
+
+        // Values must be added with Add or Merge to keep the statistics
+        void Add(double v, size_t sampleLimit = DefaultSampleLimit);
+        void Merge(const Result& rhs, size_t sampleLimit = DefaultSampleLimit);
+        bool HasAllValues() const { return value.size() == stats.GetCount(); }
+
+        double GetMin() const;
+        double GetMax() const;
+        double GetMedian() const;
+        double GetPercentile(double q) const;
+        double GetMean() const;
+        double GetStdDev() const;
+        Summary GetSummary() const;
+
+        bool operator<(const Result& rhs) const;
+
+        bool HadAnyFLTMAXValues() const { return stats.GetMax() >= FLT_MAX; }
+
+       private:
+        const vector<double>& Sorted() const;
+        void DropValues();
+
+        mutable vector<double> sorted;  // value in ascending order, built on demand
+    };
+
+   protected:
+    vector<Result> results;
+    std::map<std::pair<string, string>, size_t> index;  // (test, atts) -> results
+    std::map<string, string> metadata;                  // e.g. "device" -> "gfx90a"
+    size_t sampleLimit;
+
+   public:
+    ResultDatabase() : sampleLimit(DefaultSampleLimit) {}
+
+    void SetSampleLimit(size_t limit) { sampleLimit = limit; }
+    void AddResult(const string& test, const string& atts, const string& unit, double value);
+    void AddResults(const string& test, const string& atts, const string& unit,
+                    const vector<double>& values);
+    void Merge(const ResultDatabase& rhs);
+    vector<Result> GetResultsForTest(const string& test);
+    const vector<Result>& GetResults() const;
+    void ClearAllResults();
+    void DumpDetailed(ostream&);
+    void DumpSummary(ostream&);
+    void DumpCsv(string fileName);
+
+    void SetMetadata(const string& key, const string& value);
+    void AddHostMetadata();
+    const std::map<string, string>& GetMetadata() const { return metadata; }
+    void DumpJson(ostream&);
+
+   private:
+    Result& FindResult(const string& test, const string& atts, const string& unit);
+    vector<const Result*> SortedResults() const;
+    bool IsFileEmpty(string fileName);
+};
+
+
+#endif
@@ -0,0 +1,496 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Compares two runs written by ResultDatabase::DumpJson, and flags the results that got
+// significantly worse: the Mann-Whitney U test on the samples rejects "same distribution" at
+// the given level, and the median moved the wrong way by more than the threshold.
+// Exits with 1 when there is a regression, so that it can gate nightly runs.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Just enough of JSON for the output of DumpJson
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+    Type type;
+    double number;
+    string str;
+    vector<JsonValue> items;
+    vector<pair<string, JsonValue> > members;
+
+    JsonValue() : type(Null), number(0) {}
+
+    const JsonValue* Find(const string& key) const {
+        for (size_t i = 0; i < members.size(); i++) {
+            if (members[i].first == key) return &members[i].second;
+        }
+        return NULL;
+    }
+};
+
+class JsonParser {
+   public:
+    explicit JsonParser(const string& text) : text_(text), pos_(0) {}
+
+    bool Parse(JsonValue* value, string* error) {
+        if (!ParseValue(value) || (SkipSpace(), pos_ != text_.size())) {
+            ostringstream msg;
+            msg << "JSON syntax error at offset " << pos_;
+            *error = msg.str();
+            return false;
+        }
+        return true;
+    }
+
+   private:
+    void SkipSpace() {
+        while (pos_ < text_.size() && isspace((unsigned char)text_[pos_])) pos_++;
+    }
+
+    bool Consume(const char* word) {
+        size_t n = strlen(word);
+        if (text_.compare(pos_, n, word) != 0) return false;
+        pos_ += n;
+        return true;
+    }
+
+    bool ParseValue(JsonValue* value) {
+        SkipSpace();
+        if (pos_ >= text_.size()) return false;
+        char c = text_[pos_];
+        if (c == '{') return ParseObject(value);
+        if (c == '[') return ParseArray(value);
+        if (c == '"') {
+            value->type = JsonValue::String;
+            return ParseString(&value->str);
+        }
+        if (Consume("null")) {
+            value->type = JsonValue::Null;
+            return true;
+        }
+        if (Consume("true")) {
+            value->type = JsonValue::Bool;
+            value->number = 1;
+            return true;
+        }
+        if (Consume("false")) {
+            value->type = JsonValue::Bool;
+            return true;
+        }
+        const char* start = text_.c_str() + pos_;
+        char* end;
+        value->number = strtod(start, &end);
+        if (end == start) return false;
+        value->type = JsonValue::Number;
+        pos_ += end - start;
+        return true;
+    }
+
+    bool ParseString(string* out) {
+        pos_++;  // '"'
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                *out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) return false;
+            c = text_[pos_++];
+            switch (c) {
+                case 'b': *out += '\b'; break;
+                case 'f': *out += '\f'; break;
+                case 'n': *out += '\n'; break;
+                case 'r': *out += '\r'; break;
+                case 't': *out += '\t'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) return false;
+                    unsigned code = strtoul(text_.substr(pos_, 4).c_str(), NULL, 16);
+                    pos_ += 4;
+                    // Only the code points DumpJson escapes, plus plain UTF-8 encoding
+                    if (code < 0x80) {
+                        *out += char(code);
+                    } else if (code < 0x800) {
+                        *out += char(0xc0 | (code >> 6));
+                        *out += char(0x80 | (code & 0x3f));
+                    } else {
+                        *out += char(0xe0 | (code >> 12));
+                        *out += char(0x80 | ((code >> 6) & 0x3f));
+                        *out += char(0x80 | (code & 0x3f));
+                    }
+                    break;
+                }
+                default: *out += c; break;
+            }
+        }
+        return false;
+    }
+
+    bool ParseArray(JsonValue* value) {
+        value->type = JsonValue::Array;
+        pos_++;  // '['
+        SkipSpace();
+        if (Consume("]")) return true;
+        for (;;) {
+            value->items.push_back(JsonValue());
+            if (!ParseValue(&value->items.back())) return false;
+            SkipSpace();
+            if (Consume("]")) return true;
+            if (!Consume(",")) return false;
+        }
+    }
+
+    bool ParseObject(JsonValue* value) {
+        value->type = JsonValue::Object;
+        pos_++;  // '{'
+        SkipSpace();
+        if (Consume("}")) return true;
+        for (;;) {
+            SkipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') return false;
+            value->members.push_back(make_pair(string(), JsonValue()));
+            if (!ParseString(&value->members.back().first)) return false;
+            SkipSpace();
+            if (!Consume(":")) return false;
+            if (!ParseValue(&value->members.back().second)) return false;
+            SkipSpace();
+            if (Consume("}")) return true;
+            if (!Consume(",")) return false;
+        }
+    }
+
+    const string& text_;
+    size_t pos_;
+};
+
+// One result of a run, as written by DumpJson
+struct RunResult {
+    string unit;
+    double median;
+    vector<double> samples;  // without the missing values
+    bool missing;            // all values were missing
+};
+
+typedef pair<string, string> ResultKey;  // test, atts
+
+struct Run {
+    map<string, string> metadata;
+    map<ResultKey, RunResult> results;
+    vector<ResultKey> order;
+};
+
+string StringMember(const JsonValue& object, const char* key) {
+    const JsonValue* v = object.Find(key);
+    return v && v->type == JsonValue::String ? v->str : string();
+}
+
+bool LoadRun(const char* fileName, Run* run, string* error) {
+    ifstream file(fileName);
+    if (!file.good()) {
+        *error = "cannot open";
+        return false;
+    }
+    stringstream text;
+    text << file.rdbuf();
+    string contents = text.str();
+
+    JsonValue root;
+    if (!JsonParser(contents).Parse(&root, error)) return false;
+    const JsonValue* version = root.Find("version");
+    const JsonValue* results = root.Find("results");
+    if (StringMember(root, "schema") != "resultdb" || !version ||
+        version->type != JsonValue::Number || !results || results->type != JsonValue::Array) {
+        *error = "not a ResultDatabase JSON file";
+        return false;
+    }
+    if (version->number != 1) {
+        ostringstream msg;
+        msg << "unsupported version " << version->number;
+        *error = msg.str();
+        return false;
+    }
+
+    const JsonValue* metadata = root.Find("metadata");
+    if (metadata) {
+        for (size_t i = 0; i < metadata->members.size(); i++) {
+            run->metadata[metadata->members[i].first] = metadata->members[i].second.str;
+        }
+    }
+    for (size_t i = 0; i < results->items.size(); i++) {
+        const JsonValue& r = results->items[i];
+        ResultKey key(StringMember(r, "test"), StringMember(r, "atts"));
+        RunResult result;
+        result.unit = StringMember(r, "unit");
+        result.median = 0;
+        result.missing = true;
+        const JsonValue* stats = r.Find("stats");
+        const JsonValue* median = stats ? stats->Find("median") : NULL;
+        if (median && median->type == JsonValue::Number) {
+            result.median = median->number;
+            result.missing = false;
+        }
+        const JsonValue* samples = r.Find("samples");
+        for (size_t j = 0; samples && j < samples->items.size(); j++) {
+            if (samples->items[j].type == JsonValue::Number) {
+                result.samples.push_back(samples->items[j].number);
+            }
+        }
+        if (run->results.find(key) == run->results.end()) run->order.push_back(key);
+        run->results[key] = result;
+    }
+    return true;
+}
+
+// ****************************************************************************
+//  Function:  MannWhitneyU
+//
+//  Purpose:
+//    Two-sided p-value of the Mann-Whitney U test that a and b come from the
+//    same distribution, with the normal approximation corrected for ties and
+//    for continuity.  Returns 1 when there are not enough samples.
+//
+// ****************************************************************************
+double MannWhitneyU(const vector<double>& a, const vector<double>& b) {
+    size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    if (n1 < 2 || n2 < 2) return 1;
+
+    vector<pair<double, int> > all;
+    for (size_t i = 0; i < n1; i++) all.push_back(make_pair(a[i], 0));
+    for (size_t i = 0; i < n2; i++) all.push_back(make_pair(b[i], 1));
+    sort(all.begin(), all.end());
+
+    // Ranks from 1, ties get the average of their ranks
+    double rankSumA = 0, tieTerm = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].first == all[i].first) j++;
+        double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            if (all[k].second == 0) rankSumA += rank;
+        }
+        double t = double(j - i);
+        tieTerm += t * t * t - t;
+        i = j;
+    }
+
+    double u = rankSumA - n1 * (n1 + 1) / 2.0;
+    double mu = n1 * double(n2) / 2;
+    double sigma = sqrt(n1 * double(n2) / 12 * ((n + 1) - tieTerm / (double(n) * (n - 1))));
+    if (sigma == 0) return 1;
+    double z = (fabs(u - mu) - 0.5) / sigma;
+    if (z < 0) z = 0;
+    return erfc(z / sqrt(2.0));
+}
+
+// Throughput units are better higher, times are better lower
+bool HigherIsBetter(const string& unit) {
+    string u;
+    for (size_t i = 0; i < unit.size(); i++) u += char(tolower((unsigned char)unit[i]));
+    return u.find("/s") != string::npos || u.find("ops") != string::npos ||
+           u.find("flop") != string::npos;
+}
+
+enum Direction { DirectionFromUnit, DirectionHigher, DirectionLower };
+
+struct Options {
+    double threshold;  // percent change of the median
+    double alpha;      // significance level
+    Direction direction;
+    bool verbose;
+};
+
+void help() {
+    printf("Usage: resultdb-compare [OPTIONS] baseline.json new.json\n");
+    printf("  --threshold, -t <percent> : Smallest change of the median that counts (default 5).\n");
+    printf("  --alpha, -a <p>           : Significance level of the U test (default 0.05).\n");
+    printf("  --higher-is-better        : Treat an increase as an improvement for all units.\n");
+    printf("  --lower-is-better         : Treat a decrease as an improvement for all units.\n");
+    printf("                              Default: higher is better for units with /s,\n");
+    printf("                              ops or flop in them, lower for the others.\n");
+    printf("  --verbose, -v             : Print every result, not only the changed ones.\n");
+    printf("Exits with 1 if any result regressed, 2 on errors.\n");
+}
+
+bool parseDouble(const char* str, double* output) {
+    char* next;
+    *output = strtod(str, &next);
+    return str != next && *next == 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.threshold = 5;
+    options.alpha = 0.05;
+    options.direction = DirectionFromUnit;
+    options.verbose = false;
+    vector<const char*> files;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--threshold") || !strcmp(arg, "-t")) {
+            if (++i >= argc || !parseDouble(argv[i], &options.threshold) ||
+                options.threshold < 0) {
+                fprintf(stderr, "Bad threshold argument\n");
+                return 2;
+            }
+        } else if (!strcmp(arg, "--alpha") || !strcmp(arg, "-a")) {
+            if (++i >= argc || !parseDouble(argv[i], &options.alpha) || options.alpha <= 0 ||
+                options.alpha >= 1) {
+                fprintf(stderr, "Bad alpha argument\n");
+                return 2;
+            }
+        } else if (!strcmp(arg, "--higher-is-better")) {
+            options.direction = DirectionHigher;
+        } else if (!strcmp(arg, "--lower-is-better")) {
+            options.direction = DirectionLower;
+        } else if (!strcmp(arg, "--verbose") || !strcmp(arg, "-v")) {
+            options.verbose = true;
+        } else if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            help();
+            return 0;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Bad argument '%s'\n", arg);
+            return 2;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2) {
+        help();
+        return 2;
+    }
+
+    Run runs[2];
+    for (int i = 0; i < 2; i++) {
+        string error;
+        if (!LoadRun(files[i], &runs[i], &error)) {
+            fprintf(stderr, "%s: %s\n", files[i], error.c_str());
+            return 2;
+        }
+    }
+    Run& base = runs[0];
+    Run& run = runs[1];
+
+    // Different hardware or software usually explains a difference better than the code
+    const char* keys[] = {"host", "cpu", "device", "gcnArchName", "driver", "runtime", "os"};
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (base.metadata.count(keys[i]) && run.metadata.count(keys[i]) &&
+            base.metadata[keys[i]] != run.metadata[keys[i]]) {
+            printf("Note: %s differs: '%s' vs '%s'\n", keys[i], base.metadata[keys[i]].c_str(),
+                   run.metadata[keys[i]].c_str());
+        }
+    }
+
+    int regressions = 0, improvements = 0, changed = 0, compared = 0;
+    cout << fixed << setprecision(4);
+    cout << setw(24) << "test\t" << setw(12) << "atts\t" << setw(9) << "units\t"
+         << "baseline\tnew\tchange%\tp\tverdict" << endl;
+    for (size_t i = 0; i < run.order.size(); i++) {
+        const ResultKey& key = run.order[i];
+        const RunResult& r = run.results[key];
+        map<ResultKey, RunResult>::const_iterator b = base.results.find(key);
+        const char* verdict;
+        double change = 0, p = 1;
+        bool tested = false;
+
+        if (b == base.results.end()) {
+            verdict = "new";
+        } else if (b->second.unit != r.unit) {
+            verdict = "unit changed";
+        } else if (b->second.missing || r.missing) {
+            verdict = "missing";
+        } else {
+            compared++;
+            const RunResult& old = b->second;
+            change = old.median != 0 ? (r.median - old.median) / fabs(old.median) * 100 : 0;
+            bool higher = options.direction == DirectionHigher ||
+                          (options.direction == DirectionFromUnit && HigherIsBetter(r.unit));
+            double worse = higher ? -change : change;
+            // Without samples, e.g. past the sample limit, a change can not be tested, and is
+            // reported without failing
+            tested = old.samples.size() >= 2 && r.samples.size() >= 2;
+            if (tested) p = MannWhitneyU(old.samples, r.samples);
+            bool above = fabs(change) > options.threshold;
+            bool significant = tested && p < options.alpha && above;
+            if (significant && worse > 0) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else if (significant) {
+                verdict = "improvement";
+                improvements++;
+            } else if (!tested && above) {
+                verdict = "changed (untested)";
+                changed++;
+            } else {
+                verdict = "same";
+            }
+        }
+
+        if (!options.verbose && !strcmp(verdict, "same")) continue;
+        cout << setw(24) << key.first + "\t" << setw(12) << key.second + "\t" << setw(9)
+             << r.unit + "\t";
+        if (b != base.results.end() && !b->second.missing)
+            cout << b->second.median << "\t";
+        else
+            cout << "N/A\t";
+        if (!r.missing)
+            cout << r.median << "\t";
+        else
+            cout << "N/A\t";
+        cout << setprecision(2) << change << "\t";
+        if (tested)
+            cout << setprecision(4) << p << "\t";
+        else
+            cout << "N/A\t";
+        cout << setprecision(4) << verdict << endl;
+    }
+    for (size_t i = 0; i < base.order.size(); i++) {
+        if (run.results.find(base.order[i]) == run.results.end()) {
+            cout << setw(24) << base.order[i].first + "\t" << setw(12)
+                 << base.order[i].second + "\t" << "only in baseline" << endl;
+        }
+    }
+
+    cout << endl
+         << compared << " results compared, " << regressions << " regressions, " << improvements
+         << " improvements, " << changed << " untested changes (threshold " << setprecision(1)
+         << options.threshold << "%, alpha " << setprecision(3) << options.alpha << ")" << endl;
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "ApiTrace.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace hip_replay {
+
+namespace {
+
+const char kTraceMagic[8] = {'H', 'I', 'P', 'T', 'R', 'A', 'C', 'E'};
+// Calls are larger than this only if the trace is corrupt
+const uint32_t kMaxCallSize = 1u << 30;
+
+}  // namespace
+
+bool TraceWriter::Open(const std::string& path, std::string* error) {
+    Close();
+    file_ = gzopen(path.c_str(), "wb1");
+    if (file_ == nullptr) {
+        *error = "could not open " + path + ": " + strerror(errno);
+        return false;
+    }
+    gzbuffer(file_, 1 << 18);
+    FileHeader header;
+    memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+    header.version = kTraceVersion;
+    header.apiCount = HIP_API_ID_NUMBER;
+    if (gzwrite(file_, &header, sizeof(header)) != int(sizeof(header))) {
+        *error = "could not write " + path;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool TraceWriter::Write(uint32_t id, const hip_api_data_t* data, uint64_t handle,
+                        const void* hostData, uint32_t dataSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) return false;
+    size_t recordSize = hipApiTraceSize(id, data);
+    size_t size = sizeof(CallHeader) + dataSize + recordSize;
+    if (buffer_.size() < size) buffer_.resize(size);
+
+    CallHeader header;
+    header.handle = handle;
+    header.dataSize = dataSize;
+    header.recordSize = uint32_t(recordSize);
+    char* p = buffer_.data();
+    memcpy(p, &header, sizeof(header));
+    if (dataSize != 0) memcpy(p + sizeof(header), hostData, dataSize);
+    hipApiTraceEncode(id, data, p + sizeof(header) + dataSize, recordSize);
+    return gzwrite(file_, p, unsigned(size)) == int(size);
+}
+
+void TraceWriter::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ != nullptr) gzclose(file_);
+    file_ = nullptr;
+}
+
+bool TraceReader::Open(const std::string& path) {
+    Close();
+    error_.clear();
+    file_ = gzopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+        error_ = "could not open " + path + ": " + strerror(errno);
+        return false;
+    }
+    gzbuffer(file_, 1 << 18);
+    FileHeader header;
+    if (!Read(&header, sizeof(header)) || memcmp(header.magic, kTraceMagic, 8) != 0) {
+        error_ = path + " is not a HIP API trace";
+    } else if (header.version != kTraceVersion) {
+        error_ = path + " has an unsupported trace version";
+    } else if (header.apiCount != HIP_API_ID_NUMBER) {
+        error_ = path + " was recorded with another HIP version";
+    }
+    if (!error_.empty()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool TraceReader::Read(void* buffer, size_t size) {
+    return gzread(file_, buffer, unsigned(size)) == int(size);
+}
+
+bool TraceReader::Next(Call* call) {
+    if (file_ == nullptr) return false;
+    CallHeader header;
+    int got = gzread(file_, &header, sizeof(header));
+    if (got == 0 && gzeof(file_)) return false;
+    if (got != int(sizeof(header)) || header.dataSize > kMaxCallSize ||
+        header.recordSize > kMaxCallSize) {
+        error_ = "truncated or corrupt trace";
+        return false;
+    }
+    call->handle = header.handle;
+    call->hostData.resize(header.dataSize);
+    call->record.resize(header.recordSize);
+    if (!Read(call->hostData.data(), header.dataSize) ||
+        !Read(call->record.data(), header.recordSize) ||
+        !hipApiTraceDecode(call->record.data(), call->record.size(), &call->id,
+                           call->mutableData())) {
+        error_ = "truncated or corrupt trace";
+        return false;
+    }
+    return true;
+}
+
+void TraceReader::Close() {
+    if (file_ != nullptr) gzclose(file_);
+    file_ = nullptr;
+}
+
+}  // namespace hip_replay
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef API_TRACE_H
+#define API_TRACE_H
+
+// hip_api_data_t and its trace record coder, generated by hip_prof_gen.py
+#ifndef USE_PROF_API
+#define USE_PROF_API 1
+#endif
+#define HIP_PROF_HIP_API_TRACE 1
+#include <hip/hip_runtime_api.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <zlib.h>
+
+// ****************************************************************************
+// HIP API trace files, written by the recorder library and read by the replay
+// engine.
+//
+// A trace is a gzip stream: a FileHeader, then for every call a CallHeader,
+// the host data captured for the call and the record of the call encoded by
+// hipApiTraceEncode. Traces are only read with the hip_prof_str.h they were
+// written with: API IDs change between HIP versions.
+// ****************************************************************************
+namespace hip_replay {
+
+const uint32_t kTraceVersion = 1;
+
+struct FileHeader {
+    char magic[8];      // "HIPTRACE"
+    uint32_t version;   // kTraceVersion
+    uint32_t apiCount;  // HIP_API_ID_NUMBER
+};
+
+struct CallHeader {
+    uint64_t handle;      // returned through the output argument, e.g. by hipMalloc
+    uint32_t dataSize;    // of the host data, e.g. the hipMemcpyHtoD source
+    uint32_t recordSize;  // of the hipApiTraceEncode record
+};
+
+struct Call {
+    uint32_t id;
+    uint64_t handle;
+    std::vector<char> hostData;
+    std::vector<char> record;
+
+    // The decoded record, strings point into record. hip_api_data_t is not
+    // default constructible in C++ because of its dim3 arguments.
+    const hip_api_data_t& data() const {
+        return *reinterpret_cast<const hip_api_data_t*>(&storage);
+    }
+    hip_api_data_t* mutableData() { return reinterpret_cast<hip_api_data_t*>(&storage); }
+    std::aligned_storage<sizeof(hip_api_data_t), alignof(hip_api_data_t)>::type storage;
+};
+
+class TraceWriter {
+   public:
+    TraceWriter() : file_(nullptr) {}
+    ~TraceWriter() { Close(); }
+
+    bool Open(const std::string& path, std::string* error);
+    // Thread safe. Once the buffer has grown to the largest record, nothing is
+    // allocated.
+    bool Write(uint32_t id, const hip_api_data_t* data, uint64_t handle, const void* hostData,
+               uint32_t dataSize);
+    void Close();
+
+   private:
+    gzFile file_;
+    std::mutex mutex_;
+    std::vector<char> buffer_;
+};
+
+class TraceReader {
+   public:
+    TraceReader() : file_(nullptr) {}
+    ~TraceReader() { Close(); }
+
+    bool Open(const std::string& path);
+    // False at the end of the trace, or on error if error() is not empty.
+    bool Next(Call* call);
+    void Close();
+    const std::string& error() const { return error_; }
+
+   private:
+    bool Read(void* buffer, size_t size);
+
+    gzFile file_;
+    std::string error_;
+};
+
+}  // namespace hip_replay
+
+#endif  // API_TRACE_H
@@ -0,0 +1,307 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "CodeObject.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hip_replay {
+
+namespace {
+
+const char kBundleMagic[] = "__CLANG_OFFLOAD_BUNDLE__";
+const size_t kBundleMagicSize = sizeof(kBundleMagic) - 1;
+const uint16_t kMachineAmdgpu = 224;  // EM_AMDGPU
+const uint32_t kSectionNote = 7;      // SHT_NOTE
+const uint32_t kNoteMetadata = 32;    // NT_AMDGPU_METADATA
+
+// Code objects and bundles are little endian, as the hosts the recorder runs on
+template <typename T>
+T Load(const unsigned char* p) {
+    T value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Reader of the MessagePack values found in the code object metadata. Every
+// Read fails the reader if the next value is not of the expected type.
+class MsgPackReader {
+   public:
+    MsgPackReader(const unsigned char* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool failed() const { return failed_; }
+
+    bool ReadMap(uint64_t* entries) { return ReadHeader(0x80, 0xde, entries); }
+    bool ReadArray(uint64_t* entries) { return ReadHeader(0x90, 0xdc, entries); }
+
+    bool ReadString(std::string* value) {
+        uint64_t size;
+        if (!Available(1)) return false;
+        uint8_t tag = *p_;
+        if ((tag & 0xe0) == 0xa0) {
+            p_++;
+            size = tag & 0x1f;
+        } else if (tag >= 0xd9 && tag <= 0xdb) {
+            p_++;
+            if (!ReadBigEndian(1u << (tag - 0xd9), &size)) return false;
+        } else {
+            return Fail();
+        }
+        if (!Available(size)) return false;
+        value->assign(reinterpret_cast<const char*>(p_), size);
+        p_ += size;
+        return true;
+    }
+
+    bool ReadUint(uint64_t* value) {
+        if (!Available(1)) return false;
+        uint8_t tag = *p_;
+        if (tag < 0x80) {
+            p_++;
+            *value = tag;
+            return true;
+        }
+        if (tag < 0xcc || tag > 0xcf) return Fail();
+        p_++;
+        return ReadBigEndian(1u << (tag - 0xcc), value);
+    }
+
+    // Skips the next value, with all the values it contains
+    void Skip() {
+        for (uint64_t values = 1; values > 0 && !failed_; values--) {
+            if (!Available(1)) return;
+            uint8_t tag = *p_++;
+            uint64_t size = 0;
+            if (tag < 0x80 || tag >= 0xe0 || tag == 0xc0 || tag == 0xc2 || tag == 0xc3) {
+                // Fixed integers, nil and booleans hold no data
+            } else if (tag < 0x90) {
+                values += 2 * uint64_t(tag & 0x0f);
+            } else if (tag < 0xa0) {
+                values += tag & 0x0f;
+            } else if (tag < 0xc0) {
+                size = tag & 0x1f;
+            } else if (tag >= 0xc4 && tag <= 0xc6) {  // bin
+                if (!ReadBigEndian(1u << (tag - 0xc4), &size)) return;
+            } else if (tag >= 0xc7 && tag <= 0xc9) {  // ext, followed by its type
+                if (!ReadBigEndian(1u << (tag - 0xc7), &size)) return;
+                size++;
+            } else if (tag == 0xca || tag == 0xcb) {  // float
+                size = (tag == 0xca) ? 4 : 8;
+            } else if (tag >= 0xcc && tag <= 0xd3) {  // integers
+                size = 1u << ((tag - 0xcc) & 3);
+            } else if (tag >= 0xd4 && tag <= 0xd8) {  // fixext, with its type
+                size = (1u << (tag - 0xd4)) + 1;
+            } else if (tag >= 0xd9 && tag <= 0xdb) {  // str
+                if (!ReadBigEndian(1u << (tag - 0xd9), &size)) return;
+            } else if (tag == 0xdc || tag == 0xdd) {
+                if (!ReadBigEndian((tag == 0xdc) ? 2 : 4, &size)) return;
+                values += size;
+                size = 0;
+            } else if (tag == 0xde || tag == 0xdf) {
+                if (!ReadBigEndian((tag == 0xde) ? 2 : 4, &size)) return;
+                values += 2 * size;
+                size = 0;
+            } else {
+                Fail();
+                return;
+            }
+            if (!Available(size)) return;
+            p_ += size;
+        }
+    }
+
+   private:
+    bool Fail() {
+        failed_ = true;
+        return false;
+    }
+    bool Available(uint64_t size) {
+        if (failed_ || size > uint64_t(end_ - p_)) return Fail();
+        return true;
+    }
+    bool ReadBigEndian(unsigned bytes, uint64_t* value) {
+        if (!Available(bytes)) return false;
+        *value = 0;
+        for (unsigned i = 0; i < bytes; i++) *value = (*value << 8) | *p_++;
+        return true;
+    }
+    // Maps and arrays: a fix type of 16 entries at most, or 16 and 32-bit sizes
+    bool ReadHeader(uint8_t fixTag, uint8_t tag16, uint64_t* entries) {
+        if (!Available(1)) return false;
+        uint8_t tag = *p_;
+        if ((tag & 0xf0) == fixTag) {
+            p_++;
+            *entries = tag & 0x0f;
+            return true;
+        }
+        if (tag != tag16 && tag != tag16 + 1) return Fail();
+        p_++;
+        return ReadBigEndian((tag == tag16) ? 2 : 4, entries);
+    }
+
+    const unsigned char* p_;
+    const unsigned char* end_;
+    bool failed_ = false;
+};
+
+void ReadArgs(MsgPackReader& in, KernelLayout* layout) {
+    uint64_t count;
+    if (!in.ReadArray(&count)) return;
+    for (; count > 0 && !in.failed(); count--) {
+        uint64_t entries;
+        if (!in.ReadMap(&entries)) return;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        std::string kind;
+        for (; entries > 0 && !in.failed(); entries--) {
+            std::string key;
+            if (!in.ReadString(&key)) return;
+            if (key == ".offset") {
+                in.ReadUint(&offset);
+            } else if (key == ".size") {
+                in.ReadUint(&size);
+            } else if (key == ".value_kind") {
+                in.ReadString(&kind);
+            } else {
+                in.Skip();
+            }
+        }
+        // Hidden arguments follow the explicit ones, and are set by the runtime
+        if (in.failed() || kind.compare(0, 7, "hidden_") == 0) continue;
+        if (offset + size > UINT32_MAX || offset + size < offset) return;
+        layout->args.push_back(KernelArg{uint32_t(offset), uint32_t(size)});
+        layout->size = std::max(layout->size, uint32_t(offset + size));
+    }
+}
+
+void ReadKernel(MsgPackReader& in, KernelLayouts* layouts) {
+    uint64_t entries;
+    if (!in.ReadMap(&entries)) return;
+    std::string name;
+    KernelLayout layout;
+    for (; entries > 0 && !in.failed(); entries--) {
+        std::string key;
+        if (!in.ReadString(&key)) return;
+        if (key == ".name") {
+            in.ReadString(&name);
+        } else if (key == ".args") {
+            ReadArgs(in, &layout);
+        } else {
+            in.Skip();
+        }
+    }
+    if (!in.failed() && !name.empty()) layouts->insert(std::make_pair(name, layout));
+}
+
+bool ReadMetadata(const unsigned char* data, size_t size, KernelLayouts* layouts) {
+    MsgPackReader in(data, size);
+    uint64_t entries;
+    if (!in.ReadMap(&entries)) return false;
+    for (; entries > 0 && !in.failed(); entries--) {
+        std::string key;
+        if (!in.ReadString(&key)) return false;
+        if (key != "amdhsa.kernels") {
+            in.Skip();
+            continue;
+        }
+        uint64_t kernels;
+        if (!in.ReadArray(&kernels)) return false;
+        for (; kernels > 0 && !in.failed(); kernels--) ReadKernel(in, layouts);
+    }
+    return !in.failed();
+}
+
+bool Contains(size_t size, uint64_t offset, uint64_t length) {
+    return offset <= size && length <= size - offset;
+}
+
+}  // namespace
+
+bool ReadCodeObject(const void* data, size_t size, KernelLayouts* layouts) {
+    const unsigned char* elf = static_cast<const unsigned char*>(data);
+    // 64-bit little endian AMDGPU ELF
+    if (size < 64 || memcmp(elf, "\177ELF\2\1", 6) != 0 || Load<uint16_t>(elf + 18) != kMachineAmdgpu) {
+        return false;
+    }
+    uint64_t shoff = Load<uint64_t>(elf + 40);
+    uint16_t shentsize = Load<uint16_t>(elf + 58);
+    uint16_t shnum = Load<uint16_t>(elf + 60);
+    if (shentsize < 64 || !Contains(size, shoff, uint64_t(shnum) * shentsize)) return false;
+
+    bool found = false;
+    for (uint16_t i = 0; i < shnum; i++) {
+        const unsigned char* header = elf + shoff + uint64_t(i) * shentsize;
+        if (Load<uint32_t>(header + 4) != kSectionNote) continue;
+        uint64_t offset = Load<uint64_t>(header + 24);
+        uint64_t length = Load<uint64_t>(header + 32);
+        if (!Contains(size, offset, length)) continue;
+        // Notes are a header of three words, then the name and the description, each padded to 4 bytes
+        uint64_t end = offset + length;
+        while (end - offset >= 12) {
+            uint32_t nameSize = Load<uint32_t>(elf + offset);
+            uint32_t descSize = Load<uint32_t>(elf + offset + 4);
+            uint32_t type = Load<uint32_t>(elf + offset + 8);
+            uint64_t name = offset + 12;
+            uint64_t desc = name + ((uint64_t(nameSize) + 3) & ~uint64_t(3));
+            if (desc > end || descSize > end - desc) break;
+            if (type == kNoteMetadata && nameSize == 7 && memcmp(elf + name, "AMDGPU", 7) == 0) {
+                found = ReadMetadata(elf + desc, descSize, layouts) || found;
+            }
+            offset = desc + ((uint64_t(descSize) + 3) & ~uint64_t(3));
+        }
+    }
+    return found;
+}
+
+bool ReadOffloadBundle(const void* data, size_t size, KernelLayouts* layouts) {
+    const unsigned char* bundle = static_cast<const unsigned char*>(data);
+    if (size < kBundleMagicSize + 8 || memcmp(bundle, kBundleMagic, kBundleMagicSize) != 0) {
+        return false;
+    }
+    uint64_t entries = Load<uint64_t>(bundle + kBundleMagicSize);
+    uint64_t entry = kBundleMagicSize + 8;
+    for (uint64_t i = 0; i < entries && Contains(size, entry, 24); i++) {
+        uint64_t offset = Load<uint64_t>(bundle + entry);
+        uint64_t length = Load<uint64_t>(bundle + entry + 8);
+        uint64_t tripleSize = Load<uint64_t>(bundle + entry + 16);
+        if (!Contains(size, entry + 24, tripleSize)) break;
+        std::string triple(reinterpret_cast<const char*>(bundle + entry + 24), tripleSize);
+        entry += 24 + tripleSize;
+        // e.g. "hipv4-amdgcn-amd-amdhsa--gfx906", the host entry is empty
+        if (triple.find("amdgcn") != std::string::npos && Contains(size, offset, length)) {
+            ReadCodeObject(bundle + offset, length, layouts);
+        }
+    }
+    return true;
+}
+
+void PackKernelArgs(const KernelLayout& layout, void* const* args, std::vector<char>* buffer) {
+    size_t base = buffer->size();
+    buffer->resize(base + layout.size);
+    for (size_t i = 0; i < layout.args.size(); i++) {
+        const KernelArg& arg = layout.args[i];
+        memcpy(buffer->data() + base + arg.offset, args[i], arg.size);
+    }
+}
+
+}  // namespace hip_replay
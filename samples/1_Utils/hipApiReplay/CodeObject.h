@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef CODE_OBJECT_H
+#define CODE_OBJECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ****************************************************************************
+// Kernel argument layouts, read from the metadata of AMDGPU code objects: the
+// NT_AMDGPU_METADATA note of code object v3 and later, a MessagePack map whose
+// amdhsa.kernels entries list the offset and size of every argument.
+//
+// The recorder uses them to copy the arguments of launches that pass them as
+// an array of pointers, whose sizes are not given by the call.
+// ****************************************************************************
+namespace hip_replay {
+
+struct KernelArg {
+    uint32_t offset;  // in the kernel argument segment
+    uint32_t size;
+};
+
+struct KernelLayout {
+    std::vector<KernelArg> args;  // explicit arguments, without the hidden ones
+    uint32_t size = 0;            // of the explicit arguments
+};
+
+// By kernel name, e.g. "_Z5scalePfi"
+typedef std::map<std::string, KernelLayout> KernelLayouts;
+
+// Adds the kernels of a code object, an AMDGPU ELF file. Kernels already in
+// layouts are kept. False if it is not a code object with metadata.
+bool ReadCodeObject(const void* data, size_t size, KernelLayouts* layouts);
+
+// Adds the kernels of every amdgcn code object of a clang offload bundle.
+// size is SIZE_MAX if it is not known, e.g. for the bundles registered by
+// __hipRegisterFatBinary. False if it is not an offload bundle.
+bool ReadOffloadBundle(const void* data, size_t size, KernelLayouts* layouts);
+
+// Appends the explicit arguments of a launch, given as an array of pointers
+// to each of them (hipLaunchKernel's args, hipModuleLaunchKernel's
+// kernelParams), laid out as in the kernel argument segment.
+void PackKernelArgs(const KernelLayout& layout, void* const* args, std::vector<char>* buffer);
+
+}  // namespace hip_replay
+
+#endif  // CODE_OBJECT_H
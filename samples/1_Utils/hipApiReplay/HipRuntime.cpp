@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Replayer.h"
+
+namespace hip_replay {
+
+hipError_t HipRuntime::SetDevice(int device) { return hipSetDevice(device); }
+
+hipError_t HipRuntime::DeviceSynchronize() { return hipDeviceSynchronize(); }
+
+hipError_t HipRuntime::Malloc(void** ptr, size_t size) { return hipMalloc(ptr, size); }
+
+hipError_t HipRuntime::HostMalloc(void** ptr, size_t size, unsigned int flags) {
+    return hipHostMalloc(ptr, size, flags);
+}
+
+hipError_t HipRuntime::Free(void* ptr) { return hipFree(ptr); }
+
+hipError_t HipRuntime::HostFree(void* ptr) { return hipHostFree(ptr); }
+
+hipError_t HipRuntime::Memcpy(void* dst, const void* src, size_t size, hipMemcpyKind kind) {
+    return hipMemcpy(dst, src, size, kind);
+}
+
+hipError_t HipRuntime::MemcpyAsync(void* dst, const void* src, size_t size, hipMemcpyKind kind,
+                                   hipStream_t stream) {
+    return hipMemcpyAsync(dst, src, size, kind, stream);
+}
+
+hipError_t HipRuntime::Memset(void* dst, int value, size_t size) {
+    return hipMemset(dst, value, size);
+}
+
+hipError_t HipRuntime::MemsetAsync(void* dst, int value, size_t size, hipStream_t stream) {
+    return hipMemsetAsync(dst, value, size, stream);
+}
+
+hipError_t HipRuntime::StreamCreate(hipStream_t* stream, unsigned int flags, int priority) {
+    return hipStreamCreateWithPriority(stream, flags, priority);
+}
+
+hipError_t HipRuntime::StreamDestroy(hipStream_t stream) { return hipStreamDestroy(stream); }
+
+hipError_t HipRuntime::StreamSynchronize(hipStream_t stream) {
+    return hipStreamSynchronize(stream);
+}
+
+hipError_t HipRuntime::StreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int flags) {
+    return hipStreamWaitEvent(stream, event, flags);
+}
+
+hipError_t HipRuntime::EventCreate(hipEvent_t* event, unsigned int flags) {
+    return hipEventCreateWithFlags(event, flags);
+}
+
+hipError_t HipRuntime::EventDestroy(hipEvent_t event) { return hipEventDestroy(event); }
+
+hipError_t HipRuntime::EventRecord(hipEvent_t event, hipStream_t stream) {
+    return hipEventRecord(event, stream);
+}
+
+hipError_t HipRuntime::EventSynchronize(hipEvent_t event) { return hipEventSynchronize(event); }
+
+hipError_t HipRuntime::ModuleLoad(hipModule_t* module, const char* path) {
+    return hipModuleLoad(module, path);
+}
+
+hipError_t HipRuntime::ModuleUnload(hipModule_t module) { return hipModuleUnload(module); }
+
+hipError_t HipRuntime::ModuleGetFunction(hipFunction_t* function, hipModule_t module,
+                                         const char* name) {
+    return hipModuleGetFunction(function, module, name);
+}
+
+hipError_t HipRuntime::ModuleLaunchKernel(hipFunction_t function, dim3 grid, dim3 block,
+                                          unsigned int sharedMemBytes, hipStream_t stream,
+                                          void* args, size_t argsSize) {
+    void* extra[] = {HIP_LAUNCH_PARAM_BUFFER_POINTER, args, HIP_LAUNCH_PARAM_BUFFER_SIZE,
+                     &argsSize, HIP_LAUNCH_PARAM_END};
+    return hipModuleLaunchKernel(function, grid.x, grid.y, grid.z, block.x, block.y, block.z,
+                                 sharedMemBytes, stream, nullptr,
+                                 args == nullptr ? nullptr : extra);
+}
+
+}  // namespace hip_replay
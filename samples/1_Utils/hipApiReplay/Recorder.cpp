@@ -0,0 +1,311 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Recorder library: every HIP API call of the application is written to a
+// trace, with the handles it returns and the host data it reads.
+//
+//   HIP_API_TRACE_FILE=app.hiptrace LD_PRELOAD=libhipApiRecorder.so ./app
+//
+// or hipApiRecorderStart() and hipApiRecorderStop() from the application.
+
+#include "ApiTrace.h"
+#include "CodeObject.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include <dlfcn.h>
+
+namespace {
+
+// Activity API phase of the callbacks, as in roctracer's prof_protocol.h
+const uint32_t kPhaseExit = 1;
+
+// Host data larger than this is not captured, HIP_API_TRACE_MAX_DATA
+size_t maxData = 64 << 10;
+
+// Created when the recording starts: the constructor of a static writer could
+// run after StartFromEnvironment
+hip_replay::TraceWriter* writer = nullptr;
+bool recording = false;
+
+// What the application loaded and allocated, shared by its threads
+struct State {
+    std::mutex mutex;
+    hip_replay::KernelLayouts kernels;  // of the registered fat binaries
+    std::map<uint64_t, hip_replay::KernelLayouts> modules;
+    std::map<uint64_t, hip_replay::KernelLayout> functions;
+    std::map<uintptr_t, size_t> allocations;  // device memory, by address
+};
+
+// Never destroyed: fat binaries are registered before the constructors of this
+// file run, and callbacks may come after its destructors
+State& state() {
+    static State* s = new State;
+    return *s;
+}
+
+// The sources of copies are only captured if they are not device memory
+bool IsDeviceMemory(const void* ptr) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.allocations.upper_bound(uintptr_t(ptr));
+    if (it == s.allocations.begin()) return false;
+    --it;
+    return uintptr_t(ptr) - it->first < it->second;
+}
+
+// Device allocations, by the calls that allocate device memory only
+void TrackAllocations(uint32_t id, const hip_api_data_t* data) {
+    void* const* ptr = nullptr;
+    size_t size = 0;
+    switch (id) {
+        case HIP_API_ID_hipMalloc:
+            ptr = data->args.hipMalloc.ptr;
+            size = data->args.hipMalloc.size;
+            break;
+        case HIP_API_ID_hipExtMallocWithFlags:
+            ptr = data->args.hipExtMallocWithFlags.ptr;
+            size = data->args.hipExtMallocWithFlags.sizeBytes;
+            break;
+        case HIP_API_ID_hipMallocPitch:
+            ptr = data->args.hipMallocPitch.ptr;
+            if (data->args.hipMallocPitch.pitch != nullptr) {
+                size = *data->args.hipMallocPitch.pitch * data->args.hipMallocPitch.height;
+            }
+            break;
+        case HIP_API_ID_hipFree: {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.allocations.erase(uintptr_t(data->args.hipFree.ptr));
+            return;
+        }
+        default:
+            return;
+    }
+    if (ptr == nullptr || *ptr == nullptr) return;
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.allocations[uintptr_t(*ptr)] = size;
+}
+
+// The kernel argument layouts of the code objects loaded with hipModuleLoad
+void TrackModules(uint32_t id, const hip_api_data_t* data, uint64_t handle) {
+    if (id == HIP_API_ID_hipModuleLoad && handle != 0) {
+        std::ifstream file(data->args.hipModuleLoad.fname, std::ios::binary);
+        std::vector<char> co((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        hip_replay::KernelLayouts kernels;
+        if (!hip_replay::ReadOffloadBundle(co.data(), co.size(), &kernels)) {
+            hip_replay::ReadCodeObject(co.data(), co.size(), &kernels);
+        }
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.modules[handle].swap(kernels);
+    } else if (id == HIP_API_ID_hipModuleGetFunction && handle != 0) {
+        const auto& a = data->args.hipModuleGetFunction;
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const hip_replay::KernelLayouts& kernels = s.modules[uint64_t(uintptr_t(a.module))];
+        auto kernel = kernels.find(a.kname);
+        if (kernel != kernels.end()) s.functions[handle] = kernel->second;
+    }
+}
+
+// The handle returned through the output argument of the call
+uint64_t OutputHandle(uint32_t id, const hip_api_data_t* data) {
+    const void* out = nullptr;
+    switch (id) {
+        case HIP_API_ID_hipMalloc: out = data->args.hipMalloc.ptr; break;
+        case HIP_API_ID_hipHostMalloc: out = data->args.hipHostMalloc.ptr; break;
+        case HIP_API_ID_hipStreamCreate: out = data->args.hipStreamCreate.stream; break;
+        case HIP_API_ID_hipStreamCreateWithFlags:
+            out = data->args.hipStreamCreateWithFlags.stream;
+            break;
+        case HIP_API_ID_hipStreamCreateWithPriority:
+            out = data->args.hipStreamCreateWithPriority.stream;
+            break;
+        case HIP_API_ID_hipEventCreate: out = data->args.hipEventCreate.event; break;
+        case HIP_API_ID_hipEventCreateWithFlags:
+            out = data->args.hipEventCreateWithFlags.event;
+            break;
+        case HIP_API_ID_hipModuleLoad: out = data->args.hipModuleLoad.module; break;
+        case HIP_API_ID_hipModuleGetFunction: out = data->args.hipModuleGetFunction.function; break;
+        default: return 0;
+    }
+    // All of these are pointers
+    return (out == nullptr) ? 0 : uint64_t(uintptr_t(*static_cast<void* const*>(out)));
+}
+
+// The kernel arguments passed with HIP_LAUNCH_PARAM_BUFFER_POINTER
+const void* KernelArgs(void** extra, size_t* size) {
+    const void* args = nullptr;
+    for (size_t i = 0; extra != nullptr && extra[i] != HIP_LAUNCH_PARAM_END; i += 2) {
+        if (extra[i] == HIP_LAUNCH_PARAM_BUFFER_POINTER) args = extra[i + 1];
+        if (extra[i] == HIP_LAUNCH_PARAM_BUFFER_SIZE) *size = *static_cast<size_t*>(extra[i + 1]);
+    }
+    return args;
+}
+
+// Appends the arguments of a launch of a kernel of the fat binaries, false if
+// the kernel is not known
+bool PackLaunchArgs(const hip_replay::KernelLayouts& kernels, const std::string& name,
+                    void* const* args, std::vector<char>* buffer) {
+    auto kernel = kernels.find(name);
+    if (kernel == kernels.end() || args == nullptr) return false;
+    hip_replay::PackKernelArgs(kernel->second, args, buffer);
+    return true;
+}
+
+// The host data read by the call that the replay needs
+const void* HostData(uint32_t id, const hip_api_data_t* data, size_t* size) {
+    static thread_local std::vector<char> buffer;
+    *size = 0;
+    switch (id) {
+        case HIP_API_ID_hipMemcpy: {
+            const auto& a = data->args.hipMemcpy;
+            if (a.kind == hipMemcpyDeviceToHost || a.kind == hipMemcpyDeviceToDevice ||
+                IsDeviceMemory(a.src)) {
+                return nullptr;
+            }
+            *size = a.sizeBytes;
+            return a.src;
+        }
+        case HIP_API_ID_hipMemcpyAsync: {
+            const auto& a = data->args.hipMemcpyAsync;
+            if (a.kind == hipMemcpyDeviceToHost || a.kind == hipMemcpyDeviceToDevice ||
+                IsDeviceMemory(a.src)) {
+                return nullptr;
+            }
+            *size = a.sizeBytes;
+            return a.src;
+        }
+        case HIP_API_ID_hipMemcpyHtoD:
+            *size = data->args.hipMemcpyHtoD.sizeBytes;
+            return data->args.hipMemcpyHtoD.src;
+        case HIP_API_ID_hipMemcpyHtoDAsync:
+            *size = data->args.hipMemcpyHtoDAsync.sizeBytes;
+            return data->args.hipMemcpyHtoDAsync.src;
+        case HIP_API_ID_hipModuleLaunchKernel: {
+            const auto& a = data->args.hipModuleLaunchKernel;
+            if (a.kernelParams == nullptr) return KernelArgs(a.extra, size);
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto function = s.functions.find(uint64_t(uintptr_t(a.f)));
+            if (function == s.functions.end()) return nullptr;
+            buffer.clear();
+            hip_replay::PackKernelArgs(function->second, a.kernelParams, &buffer);
+            *size = buffer.size();
+            return buffer.data();
+        }
+        case HIP_API_ID_hipLaunchKernel: {
+            // The kernel name, then its arguments: the replay launches it from
+            // the code objects of the application
+            const auto& a = data->args.hipLaunchKernel;
+            const char* name = hipKernelNameRefByPtr(a.function_address, a.stream);
+            if (name == nullptr) return nullptr;
+            buffer.assign(name, name + strlen(name) + 1);
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (!PackLaunchArgs(s.kernels, name, a.args, &buffer)) return nullptr;
+            *size = buffer.size();
+            return buffer.data();
+        }
+        default:
+            return nullptr;
+    }
+}
+
+void ApiCallback(uint32_t domain, uint32_t id, const void* callbackData, void* arg) {
+    const hip_api_data_t* data = static_cast<const hip_api_data_t*>(callbackData);
+    // Handles are only known when the call returns
+    if (data->phase != kPhaseExit) return;
+    uint64_t handle = OutputHandle(id, data);
+    TrackAllocations(id, data);
+    TrackModules(id, data, handle);
+    size_t size;
+    const void* hostData = HostData(id, data, &size);
+    if (hostData == nullptr || size > maxData) size = 0;
+    writer->Write(id, data, handle, hostData, uint32_t(size));
+}
+
+}  // namespace
+
+// Interposed to read the kernel argument layouts of the fat binaries of the
+// application, which registers them before main
+extern "C" void* __hipRegisterFatBinary(const void* data) {
+    typedef void* (*RegisterFatBinary)(const void*);
+    static RegisterFatBinary next =
+        reinterpret_cast<RegisterFatBinary>(dlsym(RTLD_NEXT, "__hipRegisterFatBinary"));
+    // __CudaFatBinaryWrapper, as emitted by clang
+    struct FatBinaryWrapper {
+        uint32_t magic;  // "HIPF"
+        uint32_t version;
+        const void* binary;
+        void* unused;
+    };
+    const FatBinaryWrapper* wrapper = static_cast<const FatBinaryWrapper*>(data);
+    if (wrapper != nullptr && wrapper->magic == 0x48495046) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        hip_replay::ReadOffloadBundle(wrapper->binary, SIZE_MAX, &s.kernels);
+    }
+    return (next == nullptr) ? nullptr : next(data);
+}
+
+extern "C" bool hipApiRecorderStart(const char* path) {
+    std::string error;
+    if (recording) return false;
+    if (writer == nullptr) writer = new hip_replay::TraceWriter;
+    if (!writer->Open(path, &error)) {
+        fprintf(stderr, "hipApiRecorder: %s\n", error.c_str());
+        return false;
+    }
+    for (uint32_t id = 0; id < HIP_API_ID_NUMBER; id++) {
+        hipRegisterApiCallback(id, reinterpret_cast<void*>(ApiCallback), nullptr);
+    }
+    recording = true;
+    return true;
+}
+
+extern "C" void hipApiRecorderStop() {
+    if (!recording) return;
+    recording = false;
+    for (uint32_t id = 0; id < HIP_API_ID_NUMBER; id++) hipRemoveApiCallback(id);
+    writer->Close();
+}
+
+__attribute__((constructor)) static void StartFromEnvironment() {
+    const char* path = getenv("HIP_API_TRACE_FILE");
+    const char* max = getenv("HIP_API_TRACE_MAX_DATA");
+    if (max != nullptr) maxData = strtoull(max, nullptr, 0);
+    if (path != nullptr) hipApiRecorderStart(path);
+}
+
+// The runtime may already be gone: the trace is only flushed, and the writer is
+// kept for the callbacks that could still come
+__attribute__((destructor)) static void StopAtExit() {
+    if (writer != nullptr) writer->Close();
+}
@@ -0,0 +1,423 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Replayer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hip_replay {
+
+namespace {
+
+// Above this, the device is synchronized to release the sources of
+// asynchronous copies
+const size_t kMaxPendingSize = 256 << 20;
+
+uint64_t Key(const void* handle) { return uint64_t(uintptr_t(handle)); }
+
+}  // namespace
+
+bool Replayer::ReplayFile(const std::string& path, std::string* error) {
+    TraceReader reader;
+    if (!reader.Open(path)) {
+        *error = reader.error();
+        return false;
+    }
+    Call call;
+    while (reader.Next(&call)) Replay(call);
+    if (!reader.error().empty()) {
+        *error = path + ": " + reader.error();
+        return false;
+    }
+    return true;
+}
+
+void Replayer::Check(hipError_t status) {
+    if (status != hipSuccess) stats_.failed++;
+}
+
+void Replayer::Synchronized() {
+    pending_.clear();
+    pendingSize_ = 0;
+}
+
+void* Replayer::Remap(uint64_t recorded) const {
+    auto it = allocations_.upper_bound(recorded);
+    if (it == allocations_.begin()) return nullptr;
+    --it;
+    uint64_t offset = recorded - it->first;
+    if (offset != 0 && offset >= it->second.size) return nullptr;
+    return static_cast<char*>(it->second.ptr) + offset;
+}
+
+void Replayer::AddAllocation(uint64_t recorded, size_t size, void* ptr, bool host) {
+    if (ptr == nullptr) return;
+    // The allocation failed when it was recorded: nothing can refer to it
+    if (recorded == 0) {
+        Check(host ? runtime_.HostFree(ptr) : runtime_.Free(ptr));
+        return;
+    }
+    FreeAllocation(recorded);
+    Allocation allocation = {size, ptr, host};
+    allocations_[recorded] = allocation;
+}
+
+void Replayer::FreeAllocation(uint64_t recorded) {
+    auto it = allocations_.find(recorded);
+    if (it == allocations_.end()) return;
+    Check(it->second.host ? runtime_.HostFree(it->second.ptr) : runtime_.Free(it->second.ptr));
+    allocations_.erase(it);
+}
+
+void* Replayer::Destination(const void* recorded, size_t size) {
+    if (recorded == nullptr) return nullptr;
+    void* ptr = Remap(Key(recorded));
+    if (ptr != nullptr) return ptr;
+    if (scratch_.size() < size) {
+        // Asynchronous copies may still use the scratch memory
+        Check(runtime_.DeviceSynchronize());
+        Synchronized();
+        scratch_.resize(size);
+    }
+    return scratch_.data();
+}
+
+const void* Replayer::Source(const void* recorded, size_t size, const Call& call, bool async) {
+    if (recorded == nullptr) return nullptr;
+    void* ptr = Remap(Key(recorded));
+    if (ptr != nullptr) return ptr;
+    if (call.hostData.size() != size) return Destination(recorded, size);
+    if (!async) return call.hostData.data();
+    if (pendingSize_ + size > kMaxPendingSize) {
+        Check(runtime_.DeviceSynchronize());
+        Synchronized();
+    }
+    pending_.push_back(call.hostData);
+    pendingSize_ += size;
+    return pending_.back().data();
+}
+
+hipStream_t Replayer::Stream(hipStream_t recorded) const {
+    auto it = streams_.find(Key(recorded));
+    // Streams created before the recording started are replaced by the null stream
+    return (it == streams_.end()) ? nullptr : it->second;
+}
+
+hipEvent_t Replayer::Event(hipEvent_t recorded) {
+    if (recorded == nullptr) return nullptr;
+    auto it = events_.find(Key(recorded));
+    if (it != events_.end()) return it->second;
+    // Created before the recording started
+    hipEvent_t event = nullptr;
+    Check(runtime_.EventCreate(&event, 0));
+    events_[Key(recorded)] = event;
+    return event;
+}
+
+hipFunction_t Replayer::Kernel(const std::string& name) {
+    auto it = kernels_.find(name);
+    if (it != kernels_.end()) return it->second;
+    if (!codeObjectsLoaded_) {
+        codeObjectsLoaded_ = true;
+        for (const auto& path : codeObjects_) {
+            hipModule_t module = nullptr;
+            Check(runtime_.ModuleLoad(&module, path.c_str()));
+            if (module != nullptr) codeModules_.push_back(module);
+        }
+    }
+    hipFunction_t function = nullptr;
+    for (size_t i = 0; i < codeModules_.size() && function == nullptr; i++) {
+        // Not a failure of the replay: the kernel may be in another code object
+        if (runtime_.ModuleGetFunction(&function, codeModules_[i], name.c_str()) != hipSuccess) {
+            function = nullptr;
+        }
+    }
+    kernels_[name] = function;
+    return function;
+}
+
+void Replayer::Launch(hipFunction_t function, dim3 grid, dim3 block, unsigned int sharedMemBytes,
+                      hipStream_t stream, std::vector<char> args) {
+    for (size_t offset = 0; offset + sizeof(uint64_t) <= args.size(); offset += sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, &args[offset], sizeof(value));
+        void* ptr = Remap(value);
+        if (ptr != nullptr) memcpy(&args[offset], &ptr, sizeof(ptr));
+    }
+    Check(runtime_.ModuleLaunchKernel(function, grid, block, sharedMemBytes, stream,
+                                      args.empty() ? nullptr : args.data(), args.size()));
+}
+
+bool Replayer::LaunchKernel(const Call& call) {
+    const auto& a = call.data().args.hipModuleLaunchKernel;
+    auto function = functions_.find(Key(a.f));
+    // The arguments were not captured, e.g. kernelParams of a kernel without metadata
+    if (function == functions_.end() ||
+        ((a.kernelParams != nullptr || a.extra != nullptr) && call.hostData.empty())) {
+        return false;
+    }
+    Launch(function->second, dim3(a.gridDimX, a.gridDimY, a.gridDimZ),
+           dim3(a.blockDimX, a.blockDimY, a.blockDimZ), a.sharedMemBytes, Stream(a.stream),
+           call.hostData);
+    return true;
+}
+
+bool Replayer::LaunchHostKernel(const Call& call) {
+    const auto& a = call.data().args.hipLaunchKernel;
+    // The kernel name, then its arguments
+    auto name = std::find(call.hostData.begin(), call.hostData.end(), '\0');
+    if (name == call.hostData.end()) return false;
+    hipFunction_t function = Kernel(std::string(call.hostData.begin(), name));
+    if (function == nullptr) return false;
+    Launch(function, a.numBlocks, a.dimBlocks, (unsigned int)a.sharedMemBytes, Stream(a.stream),
+           std::vector<char>(name + 1, call.hostData.end()));
+    return true;
+}
+
+bool Replayer::Replay(const Call& call) {
+    const hip_api_data_t& d = call.data();
+    bool replayed = true;
+    stats_.calls++;
+    switch (call.id) {
+        case HIP_API_ID_hipSetDevice:
+            Check(runtime_.SetDevice(d.args.hipSetDevice.deviceId));
+            break;
+        case HIP_API_ID_hipDeviceSynchronize:
+            Check(runtime_.DeviceSynchronize());
+            Synchronized();
+            break;
+
+        case HIP_API_ID_hipMalloc: {
+            void* ptr = nullptr;
+            Check(runtime_.Malloc(&ptr, d.args.hipMalloc.size));
+            AddAllocation(call.handle, d.args.hipMalloc.size, ptr, false);
+            break;
+        }
+        case HIP_API_ID_hipHostMalloc: {
+            void* ptr = nullptr;
+            const auto& a = d.args.hipHostMalloc;
+            Check(runtime_.HostMalloc(&ptr, a.size, a.flags));
+            AddAllocation(call.handle, a.size, ptr, true);
+            break;
+        }
+        case HIP_API_ID_hipFree:
+            FreeAllocation(Key(d.args.hipFree.ptr));
+            break;
+        case HIP_API_ID_hipHostFree:
+            FreeAllocation(Key(d.args.hipHostFree.ptr));
+            break;
+
+        case HIP_API_ID_hipMemcpy: {
+            const auto& a = d.args.hipMemcpy;
+            Check(runtime_.Memcpy(Destination(a.dst, a.sizeBytes),
+                                  Source(a.src, a.sizeBytes, call, false), a.sizeBytes, a.kind));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyAsync: {
+            const auto& a = d.args.hipMemcpyAsync;
+            Check(runtime_.MemcpyAsync(Destination(a.dst, a.sizeBytes),
+                                       Source(a.src, a.sizeBytes, call, true), a.sizeBytes,
+                                       a.kind, Stream(a.stream)));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyHtoD: {
+            const auto& a = d.args.hipMemcpyHtoD;
+            Check(runtime_.Memcpy(Destination(a.dst, a.sizeBytes),
+                                  Source(a.src, a.sizeBytes, call, false), a.sizeBytes,
+                                  hipMemcpyHostToDevice));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyHtoDAsync: {
+            const auto& a = d.args.hipMemcpyHtoDAsync;
+            Check(runtime_.MemcpyAsync(Destination(a.dst, a.sizeBytes),
+                                       Source(a.src, a.sizeBytes, call, true), a.sizeBytes,
+                                       hipMemcpyHostToDevice, Stream(a.stream)));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoH: {
+            const auto& a = d.args.hipMemcpyDtoH;
+            Check(runtime_.Memcpy(Destination(a.dst, a.sizeBytes),
+                                  Source(a.src, a.sizeBytes, call, false), a.sizeBytes,
+                                  hipMemcpyDeviceToHost));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoHAsync: {
+            const auto& a = d.args.hipMemcpyDtoHAsync;
+            Check(runtime_.MemcpyAsync(Destination(a.dst, a.sizeBytes),
+                                       Source(a.src, a.sizeBytes, call, true), a.sizeBytes,
+                                       hipMemcpyDeviceToHost, Stream(a.stream)));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoD: {
+            const auto& a = d.args.hipMemcpyDtoD;
+            Check(runtime_.Memcpy(Destination(a.dst, a.sizeBytes),
+                                  Source(a.src, a.sizeBytes, call, false), a.sizeBytes,
+                                  hipMemcpyDeviceToDevice));
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoDAsync: {
+            const auto& a = d.args.hipMemcpyDtoDAsync;
+            Check(runtime_.MemcpyAsync(Destination(a.dst, a.sizeBytes),
+                                       Source(a.src, a.sizeBytes, call, true), a.sizeBytes,
+                                       hipMemcpyDeviceToDevice, Stream(a.stream)));
+            break;
+        }
+        case HIP_API_ID_hipMemset: {
+            const auto& a = d.args.hipMemset;
+            Check(runtime_.Memset(Destination(a.dst, a.sizeBytes), a.value, a.sizeBytes));
+            break;
+        }
+        case HIP_API_ID_hipMemsetAsync: {
+            const auto& a = d.args.hipMemsetAsync;
+            Check(runtime_.MemsetAsync(Destination(a.dst, a.sizeBytes), a.value, a.sizeBytes,
+                                       Stream(a.stream)));
+            break;
+        }
+
+        case HIP_API_ID_hipStreamCreate:
+        case HIP_API_ID_hipStreamCreateWithFlags:
+        case HIP_API_ID_hipStreamCreateWithPriority: {
+            unsigned int flags = 0;
+            int priority = 0;
+            if (call.id == HIP_API_ID_hipStreamCreateWithFlags) {
+                flags = d.args.hipStreamCreateWithFlags.flags;
+            } else if (call.id == HIP_API_ID_hipStreamCreateWithPriority) {
+                flags = d.args.hipStreamCreateWithPriority.flags;
+                priority = d.args.hipStreamCreateWithPriority.priority;
+            }
+            hipStream_t stream = nullptr;
+            Check(runtime_.StreamCreate(&stream, flags, priority));
+            if (stream != nullptr) streams_[call.handle] = stream;
+            break;
+        }
+        case HIP_API_ID_hipStreamDestroy: {
+            auto it = streams_.find(Key(d.args.hipStreamDestroy.stream));
+            if (it == streams_.end()) break;
+            Check(runtime_.StreamDestroy(it->second));
+            streams_.erase(it);
+            break;
+        }
+        case HIP_API_ID_hipStreamSynchronize:
+            Check(runtime_.StreamSynchronize(Stream(d.args.hipStreamSynchronize.stream)));
+            break;
+        case HIP_API_ID_hipStreamWaitEvent: {
+            const auto& a = d.args.hipStreamWaitEvent;
+            Check(runtime_.StreamWaitEvent(Stream(a.stream), Event(a.event), a.flags));
+            break;
+        }
+
+        case HIP_API_ID_hipEventCreate:
+        case HIP_API_ID_hipEventCreateWithFlags: {
+            unsigned int flags = (call.id == HIP_API_ID_hipEventCreateWithFlags)
+                ? d.args.hipEventCreateWithFlags.flags : 0;
+            hipEvent_t event = nullptr;
+            Check(runtime_.EventCreate(&event, flags));
+            if (event != nullptr) events_[call.handle] = event;
+            break;
+        }
+        case HIP_API_ID_hipEventDestroy: {
+            auto it = events_.find(Key(d.args.hipEventDestroy.event));
+            if (it == events_.end()) break;
+            Check(runtime_.EventDestroy(it->second));
+            events_.erase(it);
+            break;
+        }
+        case HIP_API_ID_hipEventRecord: {
+            const auto& a = d.args.hipEventRecord;
+            Check(runtime_.EventRecord(Event(a.event), Stream(a.stream)));
+            break;
+        }
+        case HIP_API_ID_hipEventSynchronize:
+            Check(runtime_.EventSynchronize(Event(d.args.hipEventSynchronize.event)));
+            break;
+
+        case HIP_API_ID_hipModuleLoad: {
+            hipModule_t module = nullptr;
+            Check(runtime_.ModuleLoad(&module, d.args.hipModuleLoad.fname));
+            if (module != nullptr) modules_[call.handle] = module;
+            break;
+        }
+        case HIP_API_ID_hipModuleUnload: {
+            auto it = modules_.find(Key(d.args.hipModuleUnload.module));
+            if (it == modules_.end()) break;
+            Check(runtime_.ModuleUnload(it->second));
+            modules_.erase(it);
+            break;
+        }
+        case HIP_API_ID_hipModuleGetFunction: {
+            const auto& a = d.args.hipModuleGetFunction;
+            auto module = modules_.find(Key(a.module));
+            if (module == modules_.end()) {
+                replayed = false;
+                break;
+            }
+            hipFunction_t function = nullptr;
+            Check(runtime_.ModuleGetFunction(&function, module->second, a.kname));
+            if (function != nullptr) functions_[call.handle] = function;
+            break;
+        }
+        case HIP_API_ID_hipModuleLaunchKernel:
+            replayed = LaunchKernel(call);
+            break;
+        case HIP_API_ID_hipLaunchKernel:
+            replayed = LaunchHostKernel(call);
+            break;
+
+        default:
+            replayed = false;
+            break;
+    }
+    if (replayed) {
+        stats_.replayed++;
+    } else {
+        stats_.skipped[hip_api_name(call.id)]++;
+    }
+    return replayed;
+}
+
+void Replayer::Release() {
+    if (allocations_.empty() && streams_.empty() && events_.empty() && modules_.empty() &&
+        codeModules_.empty()) {
+        return;
+    }
+    Check(runtime_.DeviceSynchronize());
+    Synchronized();
+    for (auto& event : events_) Check(runtime_.EventDestroy(event.second));
+    for (auto& stream : streams_) Check(runtime_.StreamDestroy(stream.second));
+    for (auto& allocation : allocations_) {
+        Check(allocation.second.host ? runtime_.HostFree(allocation.second.ptr)
+                                     : runtime_.Free(allocation.second.ptr));
+    }
+    for (auto& module : modules_) Check(runtime_.ModuleUnload(module.second));
+    for (auto& module : codeModules_) Check(runtime_.ModuleUnload(module));
+    events_.clear();
+    streams_.clear();
+    allocations_.clear();
+    modules_.clear();
+    functions_.clear();
+    codeModules_.clear();
+    codeObjectsLoaded_ = false;
+    kernels_.clear();
+}
+
+}  // namespace hip_replay
@@ -0,0 +1,190 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include "ApiTrace.h"
+
+#include <map>
+#include <string>
+
+// ****************************************************************************
+// Replays HIP API traces: the launches, copies and synchronizations of the
+// recorded application are issued again, without the application.
+//
+// Handles of the trace (allocations, streams, events, modules and functions)
+// are remapped to the ones created by the replay. Device pointers are also
+// remapped inside the kernel argument buffers, at every 8-byte aligned offset.
+// Host memory that was not captured is replaced by scratch memory.
+//
+// The kernels of hipLaunchKernel are host functions of the application: they
+// are launched by name from the code objects given with AddCodeObject.
+//
+// Calls go through Runtime, so that the replay can run against a stub.
+// ****************************************************************************
+namespace hip_replay {
+
+class Runtime {
+   public:
+    virtual ~Runtime() {}
+
+    virtual hipError_t SetDevice(int device) = 0;
+    virtual hipError_t DeviceSynchronize() = 0;
+
+    virtual hipError_t Malloc(void** ptr, size_t size) = 0;
+    virtual hipError_t HostMalloc(void** ptr, size_t size, unsigned int flags) = 0;
+    virtual hipError_t Free(void* ptr) = 0;
+    virtual hipError_t HostFree(void* ptr) = 0;
+    virtual hipError_t Memcpy(void* dst, const void* src, size_t size, hipMemcpyKind kind) = 0;
+    virtual hipError_t MemcpyAsync(void* dst, const void* src, size_t size, hipMemcpyKind kind,
+                                   hipStream_t stream) = 0;
+    virtual hipError_t Memset(void* dst, int value, size_t size) = 0;
+    virtual hipError_t MemsetAsync(void* dst, int value, size_t size, hipStream_t stream) = 0;
+
+    virtual hipError_t StreamCreate(hipStream_t* stream, unsigned int flags, int priority) = 0;
+    virtual hipError_t StreamDestroy(hipStream_t stream) = 0;
+    virtual hipError_t StreamSynchronize(hipStream_t stream) = 0;
+    virtual hipError_t StreamWaitEvent(hipStream_t stream, hipEvent_t event,
+                                       unsigned int flags) = 0;
+
+    virtual hipError_t EventCreate(hipEvent_t* event, unsigned int flags) = 0;
+    virtual hipError_t EventDestroy(hipEvent_t event) = 0;
+    virtual hipError_t EventRecord(hipEvent_t event, hipStream_t stream) = 0;
+    virtual hipError_t EventSynchronize(hipEvent_t event) = 0;
+
+    virtual hipError_t ModuleLoad(hipModule_t* module, const char* path) = 0;
+    virtual hipError_t ModuleUnload(hipModule_t module) = 0;
+    virtual hipError_t ModuleGetFunction(hipFunction_t* function, hipModule_t module,
+                                         const char* name) = 0;
+    virtual hipError_t ModuleLaunchKernel(hipFunction_t function, dim3 grid, dim3 block,
+                                          unsigned int sharedMemBytes, hipStream_t stream,
+                                          void* args, size_t argsSize) = 0;
+};
+
+// Runtime calling HIP
+class HipRuntime : public Runtime {
+   public:
+    hipError_t SetDevice(int device) override;
+    hipError_t DeviceSynchronize() override;
+    hipError_t Malloc(void** ptr, size_t size) override;
+    hipError_t HostMalloc(void** ptr, size_t size, unsigned int flags) override;
+    hipError_t Free(void* ptr) override;
+    hipError_t HostFree(void* ptr) override;
+    hipError_t Memcpy(void* dst, const void* src, size_t size, hipMemcpyKind kind) override;
+    hipError_t MemcpyAsync(void* dst, const void* src, size_t size, hipMemcpyKind kind,
+                           hipStream_t stream) override;
+    hipError_t Memset(void* dst, int value, size_t size) override;
+    hipError_t MemsetAsync(void* dst, int value, size_t size, hipStream_t stream) override;
+    hipError_t StreamCreate(hipStream_t* stream, unsigned int flags, int priority) override;
+    hipError_t StreamDestroy(hipStream_t stream) override;
+    hipError_t StreamSynchronize(hipStream_t stream) override;
+    hipError_t StreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int flags) override;
+    hipError_t EventCreate(hipEvent_t* event, unsigned int flags) override;
+    hipError_t EventDestroy(hipEvent_t event) override;
+    hipError_t EventRecord(hipEvent_t event, hipStream_t stream) override;
+    hipError_t EventSynchronize(hipEvent_t event) override;
+    hipError_t ModuleLoad(hipModule_t* module, const char* path) override;
+    hipError_t ModuleUnload(hipModule_t module) override;
+    hipError_t ModuleGetFunction(hipFunction_t* function, hipModule_t module,
+                                 const char* name) override;
+    hipError_t ModuleLaunchKernel(hipFunction_t function, dim3 grid, dim3 block,
+                                  unsigned int sharedMemBytes, hipStream_t stream, void* args,
+                                  size_t argsSize) override;
+};
+
+struct ReplayStats {
+    uint64_t calls = 0;
+    uint64_t replayed = 0;
+    uint64_t failed = 0;                        // the runtime returned an error
+    std::map<std::string, uint64_t> skipped;  // calls that cannot be replayed, by API
+};
+
+class Replayer {
+   public:
+    explicit Replayer(Runtime& runtime) : runtime_(runtime) {}
+    ~Replayer() { Release(); }
+
+    // A code object of the application, e.g. extracted with roc-obj,
+    // loaded at the first hipLaunchKernel
+    void AddCodeObject(const std::string& path) { codeObjects_.push_back(path); }
+    // Replays every call of a trace. False if the trace cannot be read.
+    bool ReplayFile(const std::string& path, std::string* error);
+    // False if the call cannot be replayed, e.g. hipLaunchKernel whose kernel
+    // is not in the code objects.
+    bool Replay(const Call& call);
+    // Frees what the trace left allocated, and synchronizes.
+    void Release();
+
+    const ReplayStats& stats() const { return stats_; }
+
+    // The replay address of a recorded device or host allocation address,
+    // nullptr if it is not in an allocation of the trace.
+    void* Remap(uint64_t recorded) const;
+
+   private:
+    struct Allocation {
+        uint64_t size;
+        void* ptr;
+        bool host;
+    };
+
+    void Check(hipError_t status);
+    void Synchronized();
+    void AddAllocation(uint64_t recorded, size_t size, void* ptr, bool host);
+    void FreeAllocation(uint64_t recorded);
+    // Memory written by a copy: host memory of the application is replaced by
+    // scratch memory
+    void* Destination(const void* recorded, size_t size);
+    // Memory read by a copy: host memory of the application is replaced by the
+    // data captured with the call, kept until the device is synchronized for
+    // asynchronous copies, else by scratch memory
+    const void* Source(const void* recorded, size_t size, const Call& call, bool async);
+    hipStream_t Stream(hipStream_t recorded) const;
+    hipEvent_t Event(hipEvent_t recorded);
+    // The kernel of the code objects, nullptr if none has it
+    hipFunction_t Kernel(const std::string& name);
+    // Launches with the recorded kernel arguments, remapped
+    void Launch(hipFunction_t function, dim3 grid, dim3 block, unsigned int sharedMemBytes,
+                hipStream_t stream, std::vector<char> args);
+    bool LaunchKernel(const Call& call);
+    bool LaunchHostKernel(const Call& call);
+
+    Runtime& runtime_;
+    ReplayStats stats_;
+    std::map<uint64_t, Allocation> allocations_;  // by recorded address
+    std::map<uint64_t, hipStream_t> streams_;
+    std::map<uint64_t, hipEvent_t> events_;
+    std::map<uint64_t, hipModule_t> modules_;
+    std::map<uint64_t, hipFunction_t> functions_;
+    std::vector<std::string> codeObjects_;
+    std::vector<hipModule_t> codeModules_;  // empty until the first hipLaunchKernel
+    bool codeObjectsLoaded_ = false;
+    std::map<std::string, hipFunction_t> kernels_;  // by name, nullptr if not found
+    std::vector<char> scratch_;
+    std::vector<std::vector<char>> pending_;  // sources of asynchronous copies
+    size_t pendingSize_ = 0;
+};
+
+}  // namespace hip_replay
+
+#endif  // REPLAYER_H
@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Replays a HIP API trace written by libhipApiRecorder.so.
+//
+//   hipApiReplay [-n] [-v] [-c code_object]... trace
+
+// hipApiTraceString, only defined in this file
+#define HIP_PROF_HIP_API_STRING 1
+#include "Replayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace hip_replay;
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [-n] [-v] [-c code_object]... trace\n"
+            "  -n  print the calls of the trace without replaying them\n"
+            "  -v  print every call as it is replayed\n"
+            "  -c  code object of the application, for the kernels of hipLaunchKernel\n",
+            name);
+}
+
+static void printCall(const Call& call, bool replayed) {
+    const char* str = hipApiTraceString(call.record.data(), call.record.size());
+    printf("%s%s\n", replayed ? "" : "[skipped] ", str);
+    free(const_cast<char*>(str));
+}
+
+int main(int argc, char* argv[]) {
+    bool dryRun = false;
+    bool verbose = false;
+    std::vector<std::string> codeObjects;
+    int opt;
+    while ((opt = getopt(argc, argv, "nvc:h")) != -1) {
+        switch (opt) {
+            case 'n': dryRun = true; break;
+            case 'v': verbose = true; break;
+            case 'c': codeObjects.push_back(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    TraceReader reader;
+    if (!reader.Open(argv[optind])) {
+        fprintf(stderr, "%s\n", reader.error().c_str());
+        return 1;
+    }
+    HipRuntime runtime;
+    Replayer replayer(runtime);
+    for (const auto& path : codeObjects) replayer.AddCodeObject(path);
+    Call call;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.Next(&call)) {
+        if (dryRun) {
+            printCall(call, true);
+            continue;
+        }
+        bool replayed = replayer.Replay(call);
+        if (verbose) printCall(call, replayed);
+    }
+    if (!reader.error().empty()) {
+        fprintf(stderr, "%s: %s\n", argv[optind], reader.error().c_str());
+        return 1;
+    }
+    if (dryRun) return 0;
+    replayer.Release();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const ReplayStats& stats = replayer.stats();
+    printf("calls %llu, replayed %llu, failed %llu, in %.3f s\n",
+           (unsigned long long)stats.calls, (unsigned long long)stats.replayed,
+           (unsigned long long)stats.failed, elapsed.count());
+    std::vector<std::pair<uint64_t, std::string>> skipped;
+    for (const auto& api : stats.skipped) skipped.push_back(std::make_pair(api.second, api.first));
+    std::sort(skipped.rbegin(), skipped.rend());
+    for (const auto& api : skipped) {
+        printf("  skipped %-40s %llu\n", api.second.c_str(), (unsigned long long)api.first);
+    }
+    return stats.failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,427 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Replays a trace against a stub runtime, and checks that the handles of the
+// trace are remapped to the ones the runtime returns. Also reads the kernel
+// argument layouts of a code object built in memory.
+
+#include "CodeObject.h"
+#include "Replayer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace hip_replay;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                \
+    do {                                                                           \
+        if (!(cond)) {                                                             \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                            \
+        }                                                                          \
+    } while (0)
+
+// Device memory is host memory, other handles are unique fake addresses
+class StubRuntime : public Runtime {
+   public:
+    hipError_t SetDevice(int device) override { return hipSuccess; }
+    hipError_t DeviceSynchronize() override { return hipSuccess; }
+    hipError_t Malloc(void** ptr, size_t size) override {
+        *ptr = calloc(1, size);
+        live.insert(*ptr);
+        return hipSuccess;
+    }
+    hipError_t HostMalloc(void** ptr, size_t size, unsigned int flags) override {
+        return Malloc(ptr, size);
+    }
+    hipError_t Free(void* ptr) override {
+        if (!Release(ptr)) return hipErrorInvalidValue;
+        free(ptr);
+        return hipSuccess;
+    }
+    hipError_t HostFree(void* ptr) override { return Free(ptr); }
+    hipError_t Memcpy(void* dst, const void* src, size_t size, hipMemcpyKind kind) override {
+        memcpy(dst, src, size);
+        return hipSuccess;
+    }
+    hipError_t MemcpyAsync(void* dst, const void* src, size_t size, hipMemcpyKind kind,
+                           hipStream_t stream) override {
+        lastStream = stream;
+        return Memcpy(dst, src, size, kind);
+    }
+    hipError_t Memset(void* dst, int value, size_t size) override {
+        memset(dst, value, size);
+        return hipSuccess;
+    }
+    hipError_t MemsetAsync(void* dst, int value, size_t size, hipStream_t stream) override {
+        lastStream = stream;
+        return Memset(dst, value, size);
+    }
+    hipError_t StreamCreate(hipStream_t* stream, unsigned int flags, int priority) override {
+        *stream = static_cast<hipStream_t>(NewHandle());
+        return hipSuccess;
+    }
+    hipError_t StreamDestroy(hipStream_t stream) override { return Check(Release(stream)); }
+    hipError_t StreamSynchronize(hipStream_t stream) override {
+        lastStream = stream;
+        return hipSuccess;
+    }
+    hipError_t StreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int flags) override {
+        lastStream = stream;
+        lastEvent = event;
+        return Check(live.count(event) != 0);
+    }
+    hipError_t EventCreate(hipEvent_t* event, unsigned int flags) override {
+        *event = static_cast<hipEvent_t>(NewHandle());
+        return hipSuccess;
+    }
+    hipError_t EventDestroy(hipEvent_t event) override { return Check(Release(event)); }
+    hipError_t EventRecord(hipEvent_t event, hipStream_t stream) override {
+        lastStream = stream;
+        lastEvent = event;
+        return Check(live.count(event) != 0);
+    }
+    hipError_t EventSynchronize(hipEvent_t event) override { return hipSuccess; }
+    hipError_t ModuleLoad(hipModule_t* module, const char* path) override {
+        modulePath = path;
+        *module = static_cast<hipModule_t>(NewHandle());
+        return hipSuccess;
+    }
+    hipError_t ModuleUnload(hipModule_t module) override { return Check(Release(module)); }
+    hipError_t ModuleGetFunction(hipFunction_t* function, hipModule_t module,
+                                 const char* name) override {
+        functionName = name;
+        if (functionName == "missing") return hipErrorInvalidValue;
+        *function = static_cast<hipFunction_t>(NewHandle());
+        return Check(live.count(module) != 0);
+    }
+    hipError_t ModuleLaunchKernel(hipFunction_t function, dim3 grid, dim3 block,
+                                  unsigned int sharedMemBytes, hipStream_t stream, void* args,
+                                  size_t argsSize) override {
+        launches++;
+        lastStream = stream;
+        lastGrid = grid;
+        kernelArgs.assign(static_cast<char*>(args), static_cast<char*>(args) + argsSize);
+        return Check(live.count(function) != 0);
+    }
+
+    std::set<const void*> live;
+    hipStream_t lastStream = nullptr;
+    hipEvent_t lastEvent = nullptr;
+    dim3 lastGrid;
+    std::string modulePath, functionName;
+    std::vector<char> kernelArgs;
+    int launches = 0;
+
+   private:
+    void* NewHandle() {
+        void* handle = reinterpret_cast<void*>(nextHandle += 0x100);
+        live.insert(handle);
+        return handle;
+    }
+    bool Release(const void* handle) { return live.erase(handle) != 0; }
+    hipError_t Check(bool ok) { return ok ? hipSuccess : hipErrorInvalidValue; }
+
+    uintptr_t nextHandle = 0x10000;
+};
+
+// Recorded handles, unrelated to the ones of the stub
+static const hipStream_t recStream = reinterpret_cast<hipStream_t>(0x5000);
+static const hipEvent_t recEvent = reinterpret_cast<hipEvent_t>(0x6000);
+static const hipModule_t recModule = reinterpret_cast<hipModule_t>(0x7000);
+static const hipFunction_t recFunction = reinterpret_cast<hipFunction_t>(0x8000);
+static char* const recBase = reinterpret_cast<char*>(0x7f0000000000ull);
+static const char kData[] = "0123456789abcdef";
+static const char kKernelName[] = "_Z5scalePfi";
+
+struct KernelArgs {
+    uint64_t ptr;
+    uint32_t n;
+    uint32_t pad;
+};
+
+static void writeTrace(const std::string& path) {
+    TraceWriter writer;
+    std::string error;
+    CHECK(writer.Open(path, &error));
+    std::aligned_storage<sizeof(hip_api_data_t), alignof(hip_api_data_t)>::type storage;
+    memset(&storage, 0, sizeof(storage));
+    hip_api_data_t& d = *reinterpret_cast<hip_api_data_t*>(&storage);
+    uint64_t none = 0;
+
+    hipStream_t stream = recStream;
+    d.args.hipStreamCreate.stream = &stream;
+    writer.Write(HIP_API_ID_hipStreamCreate, &d, uint64_t(uintptr_t(recStream)), nullptr, 0);
+    void* ptr = recBase;
+    d.args.hipMalloc.ptr = &ptr;
+    d.args.hipMalloc.size = 256;
+    writer.Write(HIP_API_ID_hipMalloc, &d, uint64_t(uintptr_t(recBase)), nullptr, 0);
+
+    // Host source captured, copied into the middle of the allocation
+    d.args.hipMemcpyHtoDAsync.dst = recBase + 64;
+    d.args.hipMemcpyHtoDAsync.src = reinterpret_cast<void*>(0x1234);
+    d.args.hipMemcpyHtoDAsync.sizeBytes = 16;
+    d.args.hipMemcpyHtoDAsync.stream = recStream;
+    writer.Write(HIP_API_ID_hipMemcpyHtoDAsync, &d, none, kData, 16);
+
+    hipEvent_t event = recEvent;
+    d.args.hipEventCreate.event = &event;
+    writer.Write(HIP_API_ID_hipEventCreate, &d, uint64_t(uintptr_t(recEvent)), nullptr, 0);
+    d.args.hipEventRecord.event = recEvent;
+    d.args.hipEventRecord.stream = recStream;
+    writer.Write(HIP_API_ID_hipEventRecord, &d, none, nullptr, 0);
+    // An event created before the recording started
+    d.args.hipStreamWaitEvent.stream = nullptr;
+    d.args.hipStreamWaitEvent.event = reinterpret_cast<hipEvent_t>(0x6100);
+    d.args.hipStreamWaitEvent.flags = 0;
+    writer.Write(HIP_API_ID_hipStreamWaitEvent, &d, none, nullptr, 0);
+
+    hipModule_t module = recModule;
+    d.args.hipModuleLoad.module = &module;
+    d.args.hipModuleLoad.fname = "kernels.co";
+    writer.Write(HIP_API_ID_hipModuleLoad, &d, uint64_t(uintptr_t(recModule)), nullptr, 0);
+    hipFunction_t function = recFunction;
+    d.args.hipModuleGetFunction.function = &function;
+    d.args.hipModuleGetFunction.module = recModule;
+    d.args.hipModuleGetFunction.kname = "scale";
+    writer.Write(HIP_API_ID_hipModuleGetFunction, &d, uint64_t(uintptr_t(recFunction)), nullptr,
+                 0);
+
+    KernelArgs args = {uint64_t(uintptr_t(recBase + 8)), 7, 0};
+    memset(&d.args.hipModuleLaunchKernel, 0, sizeof(d.args.hipModuleLaunchKernel));
+    d.args.hipModuleLaunchKernel.f = recFunction;
+    d.args.hipModuleLaunchKernel.gridDimX = 4;
+    d.args.hipModuleLaunchKernel.gridDimY = 1;
+    d.args.hipModuleLaunchKernel.gridDimZ = 1;
+    d.args.hipModuleLaunchKernel.blockDimX = 64;
+    d.args.hipModuleLaunchKernel.blockDimY = 1;
+    d.args.hipModuleLaunchKernel.blockDimZ = 1;
+    d.args.hipModuleLaunchKernel.stream = recStream;
+    d.args.hipModuleLaunchKernel.extra = reinterpret_cast<void**>(0x9000);
+    writer.Write(HIP_API_ID_hipModuleLaunchKernel, &d, none, &args, sizeof(args));
+    // kernelParams, packed by the recorder
+    d.args.hipModuleLaunchKernel.gridDimX = 2;
+    d.args.hipModuleLaunchKernel.kernelParams = reinterpret_cast<void**>(0x9100);
+    d.args.hipModuleLaunchKernel.extra = nullptr;
+    writer.Write(HIP_API_ID_hipModuleLaunchKernel, &d, none, &args, sizeof(args));
+
+    // Launched by name from the code object, then a kernel that is not in it
+    std::vector<char> named(kKernelName, kKernelName + sizeof(kKernelName));
+    named.insert(named.end(), reinterpret_cast<char*>(&args), reinterpret_cast<char*>(&args + 1));
+    memset(static_cast<void*>(&d.args.hipLaunchKernel), 0, sizeof(d.args.hipLaunchKernel));
+    d.args.hipLaunchKernel.numBlocks = dim3(3);
+    d.args.hipLaunchKernel.dimBlocks = dim3(32);
+    d.args.hipLaunchKernel.stream = recStream;
+    writer.Write(HIP_API_ID_hipLaunchKernel, &d, none, named.data(), uint32_t(named.size()));
+    writer.Write(HIP_API_ID_hipLaunchKernel, &d, none, "missing", 8);
+
+    // hipMemcpyDefault from host memory, captured
+    d.args.hipMemcpy.dst = recBase + 128;
+    d.args.hipMemcpy.src = reinterpret_cast<void*>(0x1234);
+    d.args.hipMemcpy.sizeBytes = 16;
+    d.args.hipMemcpy.kind = hipMemcpyDefault;
+    writer.Write(HIP_API_ID_hipMemcpy, &d, none, kData, 16);
+
+    d.args.hipMemsetAsync.dst = recBase;
+    d.args.hipMemsetAsync.value = 'x';
+    d.args.hipMemsetAsync.sizeBytes = 8;
+    d.args.hipMemsetAsync.stream = reinterpret_cast<hipStream_t>(0x5100);
+    writer.Write(HIP_API_ID_hipMemsetAsync, &d, none, nullptr, 0);
+    // The stream is still used by the replay when hipStreamSynchronize is called
+    d.args.hipStreamSynchronize.stream = recStream;
+    writer.Write(HIP_API_ID_hipStreamSynchronize, &d, none, nullptr, 0);
+    d.args.hipStreamDestroy.stream = recStream;
+    writer.Write(HIP_API_ID_hipStreamDestroy, &d, none, nullptr, 0);
+    writer.Close();
+}
+
+// MessagePack, as much as the code object metadata needs
+static void packString(std::vector<unsigned char>& out, const std::string& str) {
+    out.push_back(uint8_t(0xa0 | str.size()));
+    out.insert(out.end(), str.begin(), str.end());
+}
+
+static void packArg(std::vector<unsigned char>& out, uint8_t offset, uint8_t size,
+                    const std::string& kind) {
+    out.push_back(0x84);
+    packString(out, ".offset");
+    out.push_back(offset);
+    packString(out, ".size");
+    out.push_back(size);
+    packString(out, ".value_kind");
+    packString(out, kind);
+    // Skipped: an array and a float
+    packString(out, ".x");
+    out.insert(out.end(), {0x92, 0xc0, 0xcb, 0, 0, 0, 0, 0, 0, 0, 0});
+}
+
+template <typename T>
+static void put(std::vector<unsigned char>& out, size_t offset, T value) {
+    memcpy(&out[offset], &value, sizeof(value));
+}
+
+static void testCodeObject() {
+    std::vector<unsigned char> metadata = {0x82};
+    packString(metadata, "amdhsa.version");
+    metadata.insert(metadata.end(), {0x92, 0x01, 0x01});
+    packString(metadata, "amdhsa.kernels");
+    metadata.push_back(0x91);
+    metadata.push_back(0x83);
+    packString(metadata, ".name");
+    packString(metadata, kKernelName);
+    packString(metadata, ".kernarg_segment_size");
+    metadata.insert(metadata.end(), {0xcd, 0x01, 0x00});
+    packString(metadata, ".args");
+    metadata.push_back(0x93);
+    packArg(metadata, 0, 8, "global_buffer");
+    packArg(metadata, 8, 4, "by_value");
+    packArg(metadata, 16, 8, "hidden_global_offset_x");
+
+    // ELF header, the note and a single section header
+    std::vector<unsigned char> note(12 + 8);
+    put<uint32_t>(note, 0, 7);
+    put<uint32_t>(note, 4, uint32_t(metadata.size()));
+    put<uint32_t>(note, 8, 32);
+    memcpy(&note[12], "AMDGPU", 7);
+    note.insert(note.end(), metadata.begin(), metadata.end());
+    std::vector<unsigned char> elf(64);
+    memcpy(&elf[0], "\177ELF\2\1", 6);
+    put<uint16_t>(elf, 18, 224);
+    elf.insert(elf.end(), note.begin(), note.end());
+    size_t sections = elf.size();
+    elf.resize(sections + 64);
+    put<uint64_t>(elf, 40, sections);
+    put<uint16_t>(elf, 58, 64);
+    put<uint16_t>(elf, 60, 1);
+    put<uint32_t>(elf, sections + 4, 7);
+    put<uint64_t>(elf, sections + 24, 64);
+    put<uint64_t>(elf, sections + 32, note.size());
+
+    KernelLayouts layouts;
+    CHECK(ReadCodeObject(elf.data(), elf.size(), &layouts));
+    CHECK(layouts.size() == 1 && layouts.count(kKernelName) == 1);
+    const KernelLayout& layout = layouts[kKernelName];
+    CHECK(layout.size == 12 && layout.args.size() == 2);
+
+    void* ptr = recBase;
+    int n = 7;
+    void* args[] = {&ptr, &n};
+    std::vector<char> packed;
+    PackKernelArgs(layout, args, &packed);
+    CHECK(packed.size() == 12 && memcmp(&packed[0], &ptr, 8) == 0 && memcmp(&packed[8], &n, 4) == 0);
+
+    // Truncated metadata is not read
+    KernelLayouts truncated;
+    put<uint64_t>(elf, sections + 32, note.size() - 1);
+    CHECK(!ReadCodeObject(elf.data(), elf.size(), &truncated) && truncated.empty());
+}
+
+int main() {
+    char path[] = "/tmp/hipApiReplayTestXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    writeTrace(path);
+
+    StubRuntime runtime;
+    {
+        Replayer replayer(runtime);
+        replayer.AddCodeObject("app.co");
+        TraceReader reader;
+        CHECK(reader.Open(path));
+        Call call;
+        std::vector<std::string> skipped;
+        while (reader.Next(&call)) {
+            bool replayed = replayer.Replay(call);
+            if (call.id == HIP_API_ID_hipMemcpyHtoDAsync) {
+                CHECK(memcmp(replayer.Remap(uint64_t(uintptr_t(recBase + 64))), kData, 16) == 0);
+                CHECK(runtime.live.count(runtime.lastStream) != 0);
+            }
+            if (call.id == HIP_API_ID_hipStreamWaitEvent) {
+                CHECK(runtime.lastStream == nullptr && runtime.live.count(runtime.lastEvent) != 0);
+            }
+            if (call.id == HIP_API_ID_hipModuleGetFunction) {
+                CHECK(runtime.modulePath == "kernels.co" && runtime.functionName == "scale");
+            }
+            if (replayed && (call.id == HIP_API_ID_hipModuleLaunchKernel ||
+                             call.id == HIP_API_ID_hipLaunchKernel)) {
+                KernelArgs args;
+                CHECK(runtime.kernelArgs.size() == sizeof(args));
+                memcpy(&args, runtime.kernelArgs.data(), sizeof(args));
+                CHECK(args.ptr ==
+                      uint64_t(uintptr_t(replayer.Remap(uint64_t(uintptr_t(recBase + 8))))));
+                CHECK(args.n == 7);
+                CHECK(runtime.live.count(runtime.lastStream) != 0);
+            }
+            if (call.id == HIP_API_ID_hipMemcpy) {
+                CHECK(memcmp(replayer.Remap(uint64_t(uintptr_t(recBase + 128))), kData, 16) == 0);
+            }
+            if (call.id == HIP_API_ID_hipMemsetAsync) {
+                CHECK(runtime.lastStream == nullptr);
+                CHECK(memcmp(replayer.Remap(uint64_t(uintptr_t(recBase))), "xxxxxxxx", 8) == 0);
+            }
+            if (!replayed) skipped.push_back(hip_api_name(call.id));
+        }
+        CHECK(reader.error().empty());
+
+        const ReplayStats& stats = replayer.stats();
+        CHECK(stats.calls == 16);
+        CHECK(stats.replayed == 15);
+        CHECK(stats.failed == 0);
+        CHECK(skipped.size() == 1 && skipped[0] == "hipLaunchKernel");
+        CHECK(stats.skipped.size() == 1 && stats.skipped.begin()->second == 1);
+
+        CHECK(runtime.modulePath == "app.co" && runtime.functionName == "missing");
+        CHECK(runtime.launches == 3 && runtime.lastGrid.x == 3);
+        CHECK(replayer.Remap(uint64_t(uintptr_t(recBase + 256))) == nullptr);
+        // The allocation, both events, both modules and both functions
+        CHECK(runtime.live.size() == 7);
+    }
+    // Release frees all but the functions, which have no destroy call
+    CHECK(runtime.live.size() == 2);
+
+    testCodeObject();
+
+    // A truncated trace is reported
+    StubRuntime other;
+    Replayer replayer(other);
+    std::string error;
+    struct stat st;
+    CHECK(stat(path, &st) == 0 && truncate(path, st.st_size / 2) == 0);
+    CHECK(!replayer.ReplayFile(path, &error) && !error.empty());
+    unlink(path);
+
+    if (failures != 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
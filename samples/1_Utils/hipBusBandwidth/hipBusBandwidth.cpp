@@ -25,6 +25,7 @@ bool p_h2d = true;
 bool p_d2h = true;
 bool p_bidir = true;
 bool p_p2p = false;
+const char* p_json = NULL;  // also write the results with run metadata to this file
 
 
 //#define NO_CHECK
@@ -921,6 +922,33 @@ void printConfig() {
            props.clockRate / 1000.0, mallocModeString(p_malloc_mode).c_str());
 }
 
+// Writes all the results of the run, with the host, device and options
+void dumpJson(ResultDatabase& runDB, int argc, char* argv[]) {
+    hipDeviceProp_t props;
+    hipGetDeviceProperties(&props, p_device);
+    int driverVersion = 0, runtimeVersion = 0;
+    hipDriverGetVersion(&driverVersion);
+    hipRuntimeGetVersion(&runtimeVersion);
+
+    std::ostringstream command;
+    for (int i = 0; i < argc; i++) command << (i ? " " : "") << argv[i];
+
+    runDB.AddHostMetadata();
+    runDB.SetMetadata("benchmark", "hipBusBandwidth");
+    runDB.SetMetadata("command", command.str());
+    runDB.SetMetadata("device", props.name);
+    runDB.SetMetadata("gcnArchName", props.gcnArchName);
+    runDB.SetMetadata("pciBusID", std::to_string(props.pciBusID));
+    runDB.SetMetadata("driver", std::to_string(driverVersion));
+    runDB.SetMetadata("runtime", std::to_string(runtimeVersion));
+    runDB.SetMetadata("mallocMode", mallocModeString(p_malloc_mode));
+    runDB.SetMetadata("async", p_async ? "1" : "0");
+
+    std::ofstream out(p_json);
+    runDB.DumpJson(out);
+    if (!out.good()) failed("Cannot write '%s'", p_json);
+}
+
 void help() {
     printf("Usage: hipBusBandwidth [OPTIONS]\n");
     printf("  --iterations, -i         : Number of copy iterations to run.\n");
@@ -935,6 +963,7 @@ void help() {
     printf("  --p2p                    : Run only peer2peer unidir and bidir copy tests.\n");
     printf("  --verbose                : Print verbose status messages as test is run.\n");
     printf("  --detailed               : Print detailed report (including all trials).\n");
+    printf("  --json <file>            : Also write all results and the run metadata as JSON.\n");
     printf(
         "  --async                  : Use hipMemcpyAsync(with NULL stream) for H2D/D2H.  Default "
         "uses hipMemcpy.\n");
@@ -1001,6 +1030,11 @@ int parseStandardArguments(int argc, char* argv[]) {
             p_async = 1;
         } else if (!strcmp(arg, "--detailed")) {
             p_detailed = 1;
+        } else if (!strcmp(arg, "--json")) {
+            if (++i >= argc) {
+                failed("Bad json argument");
+            }
+            p_json = argv[i];
         } else {
             failed("Bad argument '%s'", arg);
         }
@@ -1013,6 +1047,8 @@ int parseStandardArguments(int argc, char* argv[]) {
 int main(int argc, char* argv[]) {
     parseStandardArguments(argc, argv);
 
+    ResultDatabase runDB;  // all the results, for --json
+
     if (p_p2p) {
         checkPeer2PeerSupport();
 
@@ -1028,6 +1064,8 @@ int main(int argc, char* argv[]) {
             resultDB_Unidir.DumpDetailed(std::cout);
             resultDB_Bidir.DumpDetailed(std::cout);
         }
+        runDB.Merge(resultDB_Unidir);
+        runDB.Merge(resultDB_Bidir);
     } else {
         printConfig();
 
@@ -1040,6 +1078,7 @@ int main(int argc, char* argv[]) {
             if (p_detailed) {
                 resultDB.DumpDetailed(std::cout);
             }
+            runDB.Merge(resultDB);
         }
 
         if (p_d2h) {
@@ -1051,6 +1090,7 @@ int main(int argc, char* argv[]) {
             if (p_detailed) {
                 resultDB.DumpDetailed(std::cout);
             }
+            runDB.Merge(resultDB);
         }
 
 
@@ -1063,6 +1103,11 @@ int main(int argc, char* argv[]) {
             if (p_detailed) {
                 resultDB.DumpDetailed(std::cout);
             }
+            runDB.Merge(resultDB);
         }
     }
+
+    if (p_json) {
+        dumpJson(runDB, argc, argv);
+    }
 }
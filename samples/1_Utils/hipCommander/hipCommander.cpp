@@ -5,15 +5,20 @@
 #include <algorithm>
 #include <string>
 #include <typeinfo>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <hip/hip_runtime.h>
 
-#include <sys/time.h>
-
 #include "ResultDatabase.h"
 #include "nullkernel.hip.cpp"
 
-bool g_printedTiming = false;
+std::atomic<bool> g_printedTiming(false);
 
 // Cmdline parms:
 int p_device = 0;
@@ -22,6 +27,7 @@ const char* p_file = nullptr;
 unsigned p_verbose = 0x0;
 unsigned p_db = 0x0;
 unsigned p_blockingSync = 0x0;
+unsigned p_deviceTime = 0x0;
 
 //---
 int p_iterations = 1;
@@ -80,6 +86,8 @@ void help() {
     printf(
         "  --verbose, -v            : Verbose printing of status.  Fore more info, combine with "
         "HIP_TRACE_API on ROCm\n");
+    printf(
+        "  --devicetime, -t         : Also time the device work of each command with events.\n");
 };
 
 
@@ -119,6 +127,9 @@ int parseStandardArguments(int argc, char* argv[]) {
         } else if (!strcmp(arg, "--blockingSync") || (!strcmp(arg, "-B"))) {
             p_blockingSync = 1;
 
+        } else if (!strcmp(arg, "--devicetime") || (!strcmp(arg, "-t"))) {
+            p_deviceTime = 1;
+
 
         } else if (!strcmp(arg, "--help") || (!strcmp(arg, "-h"))) {
             help();
@@ -132,15 +143,17 @@ int parseStandardArguments(int argc, char* argv[]) {
     return 0;
 };
 
-// Returns the current system time in microseconds
+// Returns the current time in microseconds, from a monotonic clock
 inline long long get_time() {
-    struct timeval tv;
-    gettimeofday(&tv, 0);
-    return (tv.tv_sec * 1000000) + tv.tv_usec;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
 
 class Command;
+class ThreadsCommand;
+static void printLatency(const std::vector<Command*>& commands);
 
 
 //=================================================================================================
@@ -165,6 +178,8 @@ class CommandStream {
     void run();
     void recordTime();
     void printTiming(int iterations = 0);
+    void printLatency();
+    void collectTimedCommands(std::vector<Command*>& commands) const;
 
     CommandStream* currentCommandStream() {
         return _parseInSubBlock ? _state._subBlocks.back() : this;
@@ -213,6 +228,10 @@ class CommandStream {
 
     // Track if we are parsing commands in the subblock.
     bool _parseInSubBlock;
+
+    // The threads block whose commands are being collected, and the threads blocks nested in it.
+    ThreadsCommand* _threadsBlock;
+    int _threadsDepth;
 };
 
 
@@ -245,7 +264,7 @@ class Command {
 
     void printBrief(std::ostream& s = std::cout) const { s << _args[0]; }
 
-    virtual ~Command(){};
+    virtual ~Command();
 
     virtual void print(const std::string& indent = "") const {
         std::cout << indent << "[";
@@ -256,7 +275,28 @@ class Command {
 
     virtual void run() = 0;
 
+    // Runs the command, and records the time the call takes on the host (the enqueue time for
+    // async commands), and with --devicetime the time its device work takes.
+    void timedRun();
+    // Adds the device times of the finished commands, or of all of them with @p wait.
+    void recordDeviceTimes(bool wait);
+
+    // Commands that only control the command stream are not timed.
+    virtual bool isTimed() const { return true; };
+    // The blocks of commands the command runs, if any.
+    virtual std::vector<CommandStream*> subBlocks() const { return {}; };
+
+    const std::string& name() const { return _args[0]; };
+    const ResultDatabase::Result& hostTime() const { return _hostTime; };
+    const ResultDatabase::Result& deviceTime() const { return _deviceTime; };
+
    protected:
+    // The stream that the device work of the command goes to, for the device time.
+    void setDeviceStream(hipStream_t stream) {
+        _hasDeviceWork = true;
+        _deviceStream = stream;
+    };
+
     int readIntArg(int argIndex, const std::string& argName) {
         // TODO - catch references to non-existant arguments here.
         int argVal;
@@ -272,9 +312,94 @@ class Command {
    protected:
     CommandStream* _commandStream;
     std::vector<std::string> _args;
+
+   private:
+    hipEvent_t getEvent();
+
+    // Event pairs still in flight are bounded, the oldest is waited for past this.
+    static const size_t MaxPendingEvents = 1024;
+
+    // In us, with percentiles from a histogram past the sample limit:
+    ResultDatabase::Result _hostTime;
+    ResultDatabase::Result _deviceTime;
+
+    bool _hasDeviceWork = false;
+    hipStream_t _deviceStream = nullptr;
+    std::deque<std::pair<hipEvent_t, hipEvent_t>> _pendingEvents;
+    std::vector<hipEvent_t> _freeEvents;
 };
 
 
+Command::~Command() {
+    recordDeviceTimes(true);
+    std::for_each(_freeEvents.begin(), _freeEvents.end(),
+                  [](hipEvent_t e) { HIPCHECK(hipEventDestroy(e)); });
+}
+
+
+hipEvent_t Command::getEvent() {
+    hipEvent_t e;
+    if (_freeEvents.empty()) {
+        HIPCHECK(hipEventCreate(&e));
+    } else {
+        e = _freeEvents.back();
+        _freeEvents.pop_back();
+    }
+    return e;
+}
+
+
+void Command::timedRun() {
+    if (!isTimed()) {
+        run();
+        return;
+    }
+
+    // The events are recorded outside of the host time
+    bool device = p_deviceTime && _hasDeviceWork;
+    hipEvent_t start, stop;
+    if (device) {
+        start = getEvent();
+        stop = getEvent();
+        HIPCHECK(hipEventRecord(start, _deviceStream));
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    run();
+    auto stopTime = std::chrono::steady_clock::now();
+    _hostTime.Add(std::chrono::duration<double, std::micro>(stopTime - startTime).count());
+
+    if (device) {
+        HIPCHECK(hipEventRecord(stop, _deviceStream));
+        _pendingEvents.push_back(std::make_pair(start, stop));
+        recordDeviceTimes(false);
+    }
+}
+
+
+void Command::recordDeviceTimes(bool wait) {
+    while (!_pendingEvents.empty()) {
+        std::pair<hipEvent_t, hipEvent_t> events = _pendingEvents.front();
+        if (wait || _pendingEvents.size() > MaxPendingEvents) {
+            HIPCHECK(hipEventSynchronize(events.second));
+        } else {
+            hipError_t status = hipEventQuery(events.second);
+            if (status == hipErrorNotReady) {
+                break;
+            }
+            HIPCHECK(status);
+        }
+
+        float ms;
+        HIPCHECK(hipEventElapsedTime(&ms, events.first, events.second));
+        _deviceTime.Add(ms * 1000.0);
+        _freeEvents.push_back(events.first);
+        _freeEvents.push_back(events.second);
+        _pendingEvents.pop_front();
+    }
+}
+
+
 #define FILENAME "nullkernel.hsaco"
 #define KERNEL_NAME "NullKernel"
 
@@ -284,6 +409,7 @@ class ModuleKernelCommand : public Command {
    public:
     ModuleKernelCommand(CommandStream* cmdStream, const std::vector<std::string> args)
         : Command(cmdStream, args), _stream(cmdStream->currentStream()) {
+        setDeviceStream(0);  // the launch below uses the null stream
         hipModule_t module;
         HIPCHECK(hipModuleLoad(&module, FILENAME));
         HIPCHECK(hipModuleGetFunction(&_function, module, KERNEL_NAME));
@@ -317,7 +443,9 @@ class KernelCommand : public Command {
    public:
     enum Type { Null, VectorAdd };
     KernelCommand(CommandStream* cmdStream, const std::vector<std::string> args, Type kind)
-        : Command(cmdStream, args), _kind(kind), _stream(cmdStream->currentStream()){};
+        : Command(cmdStream, args), _kind(kind), _stream(cmdStream->currentStream()) {
+        setDeviceStream(_stream);
+    };
     ~KernelCommand(){};
 
 
@@ -469,6 +597,9 @@ class LoopCommand : public Command {
     };
 
     void run() override { _commandStream->run(); };
+
+    bool isTimed() const override { return false; };
+    std::vector<CommandStream*> subBlocks() const override { return {_commandStream}; };
 };
 
 
@@ -495,6 +626,8 @@ class EndBlockCommand : public Command {
         }
     };
 
+    bool isTimed() const override { return false; };
+
    private:
     CommandStream* _blockCmdStream;
 
@@ -502,6 +635,131 @@ class EndBlockCommand : public Command {
     int _printTiming;
 };
 
+//=================================================================================================
+// Runs a block of commands on several host threads at once.  The block is parsed again for each
+// thread, so that each thread has its own commands, and its own stream from setstream(1).
+class ThreadsCommand : public Command {
+   public:
+    ThreadsCommand(CommandStream* cmdStream, const std::vector<std::string>& args)
+        : Command(cmdStream, args, 1), _printTiming(0), _wallUs(0), _runs(0) {
+        _threadCnt = readIntArg(1, "THREAD_CNT");
+        if (_threadCnt < 1) {
+            failed("bad THREAD_CNT=%s", args[1].c_str());
+        }
+    };
+
+    ~ThreadsCommand() {
+        std::for_each(_threadStreams.begin(), _threadStreams.end(),
+                      [](CommandStream* cs) { delete cs; });
+    };
+
+    // Adds a command of the block, before endthreads.
+    void addCommand(const std::string& cmd) { _block += cmd + ";"; };
+
+    // Handles endthreads: creates the command stream of each thread.
+    void endBlock(const std::vector<std::string>& args) {
+        if (args.size() > 2) {
+            failed("Too many arguments for command %s.  (Expected 1, got %zu)", args[0].c_str(),
+                   args.size() - 1);
+        }
+        if (args.size() == 2) {
+            try {
+                _printTiming = std::stoi(args[1]);
+            } catch (std::invalid_argument) {
+                failed("Command %s has bad PRINT_TIMING argument ('%s')", args[0].c_str(),
+                       args[1].c_str());
+            }
+        }
+        for (int i = 0; i < _threadCnt; i++) {
+            _threadStreams.push_back(new CommandStream("setstream(1);" + _block, 1));
+        }
+        _threadUs.resize(_threadCnt, 0);
+    };
+
+    void print(const std::string& indent = "") const override {
+        Command::print();
+        if (!_threadStreams.empty()) {
+            _threadStreams.front()->print(indent + "  ");
+        }
+    };
+
+    // The threads wait at a barrier, so that they all start submitting at once.
+    void run() override {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int ready = 0;
+        bool go = false;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < _threadCnt; i++) {
+            threads.push_back(std::thread([&, i]() {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready++;
+                    cv.notify_all();
+                    cv.wait(lock, [&]() { return go; });
+                }
+                long long startTime = get_time();
+                _threadStreams[i]->run();
+                _threadUs[i] += get_time() - startTime;
+            }));
+        }
+
+        long long startTime;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return ready == _threadCnt; });
+            go = true;
+            startTime = get_time();
+        }
+        cv.notify_all();
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t) { t.join(); });
+        _wallUs += get_time() - startTime;
+        _runs++;
+
+        if (_printTiming) {
+            printTiming();
+        }
+    };
+
+    bool isTimed() const override { return false; };
+    std::vector<CommandStream*> subBlocks() const override { return _threadStreams; };
+
+    // Prints the time of each thread, the rate all threads submitted commands at, and the
+    // latency percentiles of the commands of all threads.
+    void printTiming() {
+        g_printedTiming = true;
+
+        std::vector<Command*> commands;
+        std::for_each(_threadStreams.begin(), _threadStreams.end(),
+                      [&](CommandStream* cs) { cs->collectTimedCommands(commands); });
+        unsigned long long commandCnt = 0;
+        std::for_each(commands.begin(), commands.end(),
+                      [&](Command* c) { commandCnt += c->hostTime().stats.GetCount(); });
+
+        std::cout << "threads<" << _threadCnt << ">,command<";
+        _threadStreams.front()->printBrief(std::cout);
+        std::cout << ">,";
+        printf("    runs,%d,   wall_time,%6.3f,  commands,%llu,  commands/s,%.0f\n", _runs,
+               _wallUs, commandCnt, _wallUs ? commandCnt / (_wallUs / 1e6) : 0.0);
+        for (int i = 0; i < _threadCnt; i++) {
+            printf("    thread,%d,  time,%6.3f\n", i, _threadUs[i]);
+        }
+        ::printLatency(commands);
+    };
+
+   private:
+    int _threadCnt;
+    int _printTiming;
+    std::string _block;
+    std::vector<CommandStream*> _threadStreams;
+
+    // Us, summed over the runs of the block:
+    double _wallUs;
+    std::vector<double> _threadUs;
+    int _runs;
+};
+
 
 //=================================================================================================
 class SetStreamCommand : public Command {
@@ -514,6 +772,8 @@ class SetStreamCommand : public Command {
     };
 
     void run() override{};
+
+    bool isTimed() const override { return false; };
 };
 
 
@@ -527,6 +787,8 @@ class PrintTimingCommand : public Command {
 
     void run() override { _commandStream->printTiming(_iterations); };
 
+    bool isTimed() const override { return false; };
+
    private:
     int _iterations;
 };
@@ -553,6 +815,7 @@ CopyCommand::CopyCommand(CommandStream* cmdStream, const std::vector<std::string
     };
 
     _sizeBytes = 64;  // TODO, support reading from arg.
+    setDeviceStream(_isAsync ? _stream : 0);
 
     _dst = alloc(_sizeBytes, _dstType);
     _src = alloc(_sizeBytes, _srcType);
@@ -570,12 +833,17 @@ CommandStream::CommandStream(std::string commandStreamString, int iterations)
       _startTime(0),
       _elapsedUs(0.0),
       _parentCommandStream(nullptr),
-      _parseInSubBlock(false) {
+      _parseInSubBlock(false),
+      _threadsBlock(nullptr),
+      _threadsDepth(0) {
     std::vector<std::string> tokens;
     tokenize(commandStreamString, ';', tokens);
 
     setStream(0);
     std::for_each(tokens.begin(), tokens.end(), [&](const std::string s) { this->parse(s); });
+    if (_threadsBlock) {
+        failed("threads without corresponding endthreads command");
+    }
 }
 
 
@@ -667,6 +935,21 @@ void CommandStream::parse(std::string fullCmd) {
     }
 
 
+    if (_threadsBlock) {
+        // Each thread parses the commands of the block again, into its own command stream.
+        if (c == "threads") {
+            _threadsDepth++;
+        } else if (c == "endthreads" && _threadsDepth == 0) {
+            _threadsBlock->endBlock(args);
+            _threadsBlock = nullptr;
+            return;
+        } else if (c == "endthreads") {
+            _threadsDepth--;
+        }
+        _threadsBlock->addCommand(fullCmd);
+        return;
+    }
+
     Command* cmd = NULL;
     CommandStream* cmdStream = currentCommandStream();
 
@@ -736,6 +1019,22 @@ void CommandStream::parse(std::string fullCmd) {
         cmd = new EndBlockCommand(cmdStream, parentCmdStream, args);
         cmdStream = parentCmdStream;
 
+    } else if (c == "threads") {
+        //= threads(THREAD_CNT)
+        //= Run the next set of commands (until 'endthreads' command) on THREAD_CNT host threads
+        //= at once.  Each thread has its own copy of the commands, on its own stream.  The
+        //= threads start together, after a barrier.
+
+        _threadsBlock = new ThreadsCommand(cmdStream, args);
+        cmd = _threadsBlock;
+
+    } else if (c == "endthreads") {
+        //= endthreads(PRINT_TIMING)
+        //= End a threads block.  With PRINT_TIMING=1, prints the wall time, the time of each
+        //= thread, the rate of commands of all threads, and their latency percentiles.
+
+        failed("%s without corresponding threads command", args[0].c_str());
+
     } else {
         std::cerr << "error: Bad command '" << fullCmd << "\n";
         HIPASSERT(0, "bad command in command-stream");
@@ -768,7 +1067,7 @@ void CommandStream::run() {
             if (p_verbose) {
                 (*cmdI)->print();
             }
-            (*cmdI)->run();
+            (*cmdI)->timedRun();
         }
     }
 
@@ -800,10 +1099,65 @@ void CommandStream::printTiming(int iterations) {
         std::cout << ">,";
         printf("    iterations,%d,   total_time,%6.3f,  time/iteration,%6.3f\n", iterations,
                _elapsedUs, _elapsedUs / iterations);
+        printLatency();
     }
 };
 
 
+void CommandStream::collectTimedCommands(std::vector<Command*>& commands) const {
+    for (auto cmdI = _commands.begin(); cmdI != _commands.end(); cmdI++) {
+        std::vector<CommandStream*> blocks = (*cmdI)->subBlocks();
+        if (!blocks.empty()) {
+            for (auto blockI = blocks.begin(); blockI != blocks.end(); blockI++) {
+                (*blockI)->collectTimedCommands(commands);
+            }
+        } else if ((*cmdI)->isTimed()) {
+            commands.push_back(*cmdI);
+        }
+    }
+}
+
+
+static void printPercentiles(const std::string& name, const char* timing,
+                             const ResultDatabase::Result& r) {
+    if (r.stats.GetCount() == 0) {
+        return;
+    }
+    printf("    %s,%s,  count,%llu,  mean,%8.3f,  p50,%8.3f,  p99,%8.3f,  p99.9,%8.3f,  max,%8.3f\n",
+           name.c_str(), timing, (unsigned long long)r.stats.GetCount(), r.GetMean(),
+           r.GetPercentile(50), r.GetPercentile(99), r.GetPercentile(99.9), r.GetMax());
+}
+
+
+// Prints the latency percentiles of each type of command, in us.
+static void printLatency(const std::vector<Command*>& commands) {
+    std::vector<std::string> names;
+    std::map<std::string, std::pair<ResultDatabase::Result, ResultDatabase::Result>> times;
+    for (auto cmdI = commands.begin(); cmdI != commands.end(); cmdI++) {
+        Command* cmd = *cmdI;
+        cmd->recordDeviceTimes(true);
+        if (times.find(cmd->name()) == times.end()) {
+            names.push_back(cmd->name());
+        }
+        times[cmd->name()].first.Merge(cmd->hostTime());
+        times[cmd->name()].second.Merge(cmd->deviceTime());
+    }
+
+    for (auto nameI = names.begin(); nameI != names.end(); nameI++) {
+        printPercentiles(*nameI, "host_us", times[*nameI].first);
+        printPercentiles(*nameI, "device_us", times[*nameI].second);
+    }
+}
+
+
+// Prints the latency percentiles of the commands in the stream and its blocks.
+void CommandStream::printLatency() {
+    std::vector<Command*> commands;
+    collectTimedCommands(commands);
+    ::printLatency(commands);
+}
+
+
 //=================================================================================================
 int main(int argc, char* argv[]) {
     parseStandardArguments(argc, argv);
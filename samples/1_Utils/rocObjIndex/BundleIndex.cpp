@@ -0,0 +1,356 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "BundleIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bundle_index {
+
+namespace {
+
+const char kBundleMagic[] = "__CLANG_OFFLOAD_BUNDLE__";
+const size_t kBundleMagicSize = sizeof(kBundleMagic) - 1;
+const char kBundleSection[] = ".hip_fatbin";
+
+// Read-only mapping of a whole file.
+class MappedFile {
+   public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error_ = std::string("could not open: ") + strerror(errno);
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error_ = std::string("could not stat: ") + strerror(errno);
+        } else if (!S_ISREG(st.st_mode)) {
+            error_ = "not a regular file";
+        } else if (st.st_size > 0) {
+            void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                error_ = std::string("could not map: ") + strerror(errno);
+            } else {
+                data_ = static_cast<const unsigned char*>(data);
+                size_ = st.st_size;
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile() {
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    uint64_t size() const { return size_; }
+    const std::string& error() const { return error_; }
+
+   private:
+    const unsigned char* data_ = nullptr;
+    uint64_t size_ = 0;
+    std::string error_;
+};
+
+// Bounds-checked reader of little or big endian integers.
+class Reader {
+   public:
+    Reader(const unsigned char* data, uint64_t size, bool bigEndian)
+        : data_(data), size_(size), bigEndian_(bigEndian) {}
+
+    bool contains(uint64_t offset, uint64_t size) const {
+        return offset <= size_ && size <= size_ - offset;
+    }
+    uint64_t read(uint64_t offset, unsigned bytes) const {
+        uint64_t value = 0;
+        for (unsigned i = 0; i < bytes; i++) {
+            unsigned shift = 8 * (bigEndian_ ? bytes - 1 - i : i);
+            value |= static_cast<uint64_t>(data_[offset + i]) << shift;
+        }
+        return value;
+    }
+
+   private:
+    const unsigned char* data_;
+    uint64_t size_;
+    bool bigEndian_;
+};
+
+struct Section {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Find the .hip_fatbin section from the ELF section headers. Returns an error
+// message, or an empty string with section set (size 0 if there is none).
+std::string FindBundleSection(const MappedFile& file, Section& section) {
+    const unsigned char* data = file.data();
+    uint64_t size = file.size();
+    section = {0, 0};
+    if (size < 16 || memcmp(data, "\177ELF", 4) != 0) return "not an ELF file";
+    bool is64 = data[4] == 2;
+    if ((data[4] != 1 && data[4] != 2) || (data[5] != 1 && data[5] != 2)) {
+        return "unsupported ELF class or data encoding";
+    }
+    Reader in(data, size, data[5] == 2);
+    unsigned word = is64 ? 8 : 4;
+    uint64_t headerSize = is64 ? 64 : 52;
+    if (!in.contains(0, headerSize)) return "truncated ELF header";
+
+    uint64_t shoff = in.read(is64 ? 40 : 32, word);
+    uint64_t shentsize = in.read(is64 ? 58 : 46, 2);
+    uint64_t shnum = in.read(is64 ? 60 : 48, 2);
+    uint64_t shstrndx = in.read(is64 ? 62 : 50, 2);
+    if (shoff == 0) return "";
+    if (shentsize < (is64 ? 64u : 40u)) return "invalid section header size";
+    if (!in.contains(shoff, shentsize)) return "truncated section headers";
+    // Extended numbering: the real values are in the first section header
+    if (shnum == 0) shnum = in.read(shoff + (is64 ? 32 : 20), word);
+    if (shstrndx == 0xffff) shstrndx = in.read(shoff + (is64 ? 40 : 24), 4);
+    if (shnum > size / shentsize || !in.contains(shoff, shnum * shentsize)) {
+        return "truncated section headers";
+    }
+    if (shstrndx >= shnum) return "invalid section name table";
+
+    auto sectionOffset = [&](uint64_t index) {
+        return in.read(shoff + index * shentsize + (is64 ? 24 : 16), word);
+    };
+    auto sectionSize = [&](uint64_t index) {
+        return in.read(shoff + index * shentsize + (is64 ? 32 : 20), word);
+    };
+    uint64_t namesOffset = sectionOffset(shstrndx);
+    uint64_t namesSize = sectionSize(shstrndx);
+    if (!in.contains(namesOffset, namesSize)) return "truncated section name table";
+
+    const size_t nameSize = sizeof(kBundleSection);  // including the terminating NUL
+    for (uint64_t i = 1; i < shnum; i++) {
+        uint64_t name = in.read(shoff + i * shentsize, 4);
+        if (name >= namesSize || namesSize - name < nameSize ||
+            memcmp(data + namesOffset + name, kBundleSection, nameSize) != 0) {
+            continue;
+        }
+        const uint32_t SHT_NOBITS = 8;
+        if (in.read(shoff + i * shentsize + 4, 4) == SHT_NOBITS) return "";
+        section.offset = sectionOffset(i);
+        section.size = sectionSize(i);
+        if (!in.contains(section.offset, section.size)) {
+            return std::string(kBundleSection) + " section is truncated";
+        }
+        return "";
+    }
+    return "";
+}
+
+// Walk every offload bundle of the section. The bundles are concatenated, each
+// possibly padded for alignment, so the next one is searched after the end of
+// the code objects of the previous one.
+std::string IndexBundles(const MappedFile& file, const Section& section,
+                         std::vector<CodeObject>& codeObjects) {
+    const unsigned char* data = file.data();
+    Reader in(data, file.size(), false);
+    uint64_t end = section.offset + section.size;
+    uint64_t bundle = section.offset;
+    while (bundle < end) {
+        if (end - bundle < kBundleMagicSize + 8 ||
+            memcmp(data + bundle, kBundleMagic, kBundleMagicSize) != 0) {
+            if (bundle == section.offset) return "offload bundle magic string not detected";
+            break;
+        }
+        uint64_t entries = in.read(bundle + kBundleMagicSize, 8);
+        uint64_t entry = bundle + kBundleMagicSize + 8;
+        // Every entry takes at least 24 bytes of header
+        if (entries > (end - entry) / 24) return "invalid number of bundle entries";
+        uint64_t bundleEnd = entry;
+        for (uint64_t i = 0; i < entries; i++) {
+            if (end - entry < 24) return "truncated bundle entry";
+            uint64_t offset = in.read(entry, 8);
+            uint64_t size = in.read(entry + 8, 8);
+            uint64_t tripleSize = in.read(entry + 16, 8);
+            entry += 24;
+            if (tripleSize > end - entry) return "truncated bundle entry triple";
+            // Entry offsets are relative to the start of their bundle
+            if (offset > end - bundle || size > end - bundle - offset) {
+                return "bundle entry is outside of the " + std::string(kBundleSection) + " section";
+            }
+            codeObjects.push_back(CodeObject{
+                std::string(reinterpret_cast<const char*>(data + entry), tripleSize),
+                bundle + offset, size});
+            entry += tripleSize;
+            bundleEnd = std::max(bundleEnd, std::max(entry, bundle + offset + size));
+        }
+        const unsigned char* next = std::search(data + bundleEnd, data + end, kBundleMagic,
+                                                kBundleMagic + kBundleMagicSize);
+        bundle = next - data;
+    }
+    return "";
+}
+
+void JsonString(std::string& out, const std::string& value) {
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+}  // namespace
+
+Executable IndexExecutable(const std::string& path) {
+    Executable executable;
+    executable.path = path;
+    MappedFile file(path);
+    if (!file.error().empty()) {
+        executable.error = file.error();
+        return executable;
+    }
+    Section section;
+    executable.error = FindBundleSection(file, section);
+    if (executable.error.empty() && section.size == 0) {
+        executable.error = "no " + std::string(kBundleSection) + " section found";
+    }
+    if (executable.error.empty()) {
+        executable.error = IndexBundles(file, section, executable.codeObjects);
+    }
+    return executable;
+}
+
+void IndexExecutables(const std::vector<std::string>& paths, unsigned jobs,
+                      const std::function<void(const Executable&)>& onIndexed) {
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, paths.size()));
+    if (jobs <= 1) {
+        for (const std::string& path : paths) onIndexed(IndexExecutable(path));
+        return;
+    }
+
+    // Workers take the next path and store its index; the calling thread reports
+    // the results in order as soon as they are ready.
+    std::vector<Executable> results(paths.size());
+    std::vector<char> done(paths.size(), 0);
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; i++) {
+        workers.emplace_back([&]() {
+            for (size_t index; (index = next++) < paths.size();) {
+                Executable executable = IndexExecutable(paths[index]);
+                std::lock_guard<std::mutex> lock(mutex);
+                results[index] = std::move(executable);
+                done[index] = 1;
+                ready.notify_one();
+            }
+        });
+    }
+    for (size_t index = 0; index < paths.size(); index++) {
+        Executable executable;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return done[index] != 0; });
+            executable = std::move(results[index]);
+        }
+        onIndexed(executable);
+    }
+    for (std::thread& worker : workers) worker.join();
+}
+
+std::string UriEncode(const std::string& path) {
+    static const char kKept[] = "-._~!*'();:@&=+$,/?#[]";
+    static const char kHex[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(path.size());
+    for (unsigned char c : path) {
+        if (isalnum(c) || (c != 0 && strchr(kKept, c) != nullptr)) {
+            encoded += c;
+        } else {
+            encoded += '%';
+            encoded += kHex[c >> 4];
+            encoded += kHex[c & 15];
+        }
+    }
+    return encoded;
+}
+
+std::string CodeObjectUri(const std::string& path, const CodeObject& codeObject) {
+    return "file://" + UriEncode(path) + "#offset=" + std::to_string(codeObject.offset) +
+        "&size=" + std::to_string(codeObject.size);
+}
+
+std::string ToJson(const Executable& executable) {
+    std::string out = "{\"path\":";
+    JsonString(out, executable.path);
+    if (!executable.error.empty()) {
+        out += ",\"error\":";
+        JsonString(out, executable.error);
+        return out + "}";
+    }
+    out += ",\"codeObjects\":[";
+    for (size_t i = 0; i < executable.codeObjects.size(); i++) {
+        const CodeObject& codeObject = executable.codeObjects[i];
+        out += i ? ",{\"triple\":" : "{\"triple\":";
+        JsonString(out, codeObject.triple);
+        out += ",\"offset\":" + std::to_string(codeObject.offset);
+        out += ",\"size\":" + std::to_string(codeObject.size);
+        out += ",\"uri\":";
+        JsonString(out, CodeObjectUri(executable.path, codeObject));
+        out += "}";
+    }
+    return out + "]}";
+}
+
+}  // namespace bundle_index
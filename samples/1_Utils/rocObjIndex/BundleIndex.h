@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef BUNDLE_INDEX_H
+#define BUNDLE_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ****************************************************************************
+// Lists the code objects embedded in host executables, without running
+// objdump: the ELF section headers are read to find the .hip_fatbin section,
+// then every __CLANG_OFFLOAD_BUNDLE__ of that section is walked.
+//
+// Offsets are absolute offsets in the executable file, so that they can be
+// passed to roc-obj-extract as file:// URIs.
+// ****************************************************************************
+namespace bundle_index {
+
+struct CodeObject {
+    std::string triple;  // e.g. "hipv4-amdgcn-amd-amdhsa--gfx906"
+    uint64_t offset;     // in the executable file
+    uint64_t size;
+};
+
+struct Executable {
+    std::string path;
+    std::vector<CodeObject> codeObjects;
+    std::string error;  // empty if the executable was indexed
+};
+
+// Index a single executable. Never throws; failures are reported in error.
+Executable IndexExecutable(const std::string& path);
+
+// Index executables with up to jobs threads (0 for one per CPU). onIndexed is
+// called on the calling thread, once per executable, in the order of paths.
+void IndexExecutables(const std::vector<std::string>& paths, unsigned jobs,
+                      const std::function<void(const Executable&)>& onIndexed);
+
+// "file://<path>#offset=<offset>&size=<size>", as printed by roc-obj-ls.
+std::string CodeObjectUri(const std::string& path, const CodeObject& codeObject);
+
+// Percent-encode the characters URI::Encode encodes, for roc-obj-ls parity.
+std::string UriEncode(const std::string& path);
+
+// One JSON object per executable: {"path":...,"codeObjects":[...]} or
+// {"path":...,"error":...}.
+std::string ToJson(const Executable& executable);
+
+}  // namespace bundle_index
+
+#endif  // BUNDLE_INDEX_H
@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BundleIndex.h"
+
+static void usage(const char* program) {
+    printf("Usage: %s [-v|j|J|f|h] executable...\n", program);
+    printf("List the URIs of the code objects embedded in the specified host executables.\n");
+    printf("-v        Verbose output (includes Entry ID)\n");
+    printf("-j <n>    Index up to n executables at once (default: one per CPU)\n");
+    printf("-J        JSON output, one object per executable and per line\n");
+    printf("-f <file> Also index the executables listed in file, one per line (- for stdin)\n");
+    printf("-h        Show this help message\n");
+}
+
+static bool readList(const std::string& file, std::vector<std::string>& paths) {
+    std::ifstream list;
+    if (file != "-") {
+        list.open(file);
+        if (!list) return false;
+    }
+    std::istream& in = (file == "-") ? std::cin : list;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty()) paths.push_back(line);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool verbose = false;
+    bool json = false;
+    unsigned jobs = 0;
+    std::vector<std::string> paths;
+    int opt;
+    while ((opt = getopt(argc, argv, "vj:Jf:h")) != -1) {
+        switch (opt) {
+            case 'v':
+                verbose = true;
+                break;
+            case 'j': {
+                char* end;
+                long value = strtol(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || value < 1) {
+                    fprintf(stderr, "Error: -j expects a number of jobs, got '%s'\n", optarg);
+                    return 2;
+                }
+                jobs = static_cast<unsigned>(value);
+                break;
+            }
+            case 'J':
+                json = true;
+                break;
+            case 'f':
+                if (!readList(optarg, paths)) {
+                    fprintf(stderr, "Error: failed to open file: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    paths.insert(paths.end(), argv + optind, argv + argc);
+
+    int status = 0;
+    bundle_index::IndexExecutables(
+        paths, jobs, [&](const bundle_index::Executable& executable) {
+            if (!executable.error.empty()) status = 1;
+            // Errors are only in the "error" member, the output is parsed
+            if (json) {
+                printf("%s\n", bundle_index::ToJson(executable).c_str());
+                return;
+            }
+            if (!executable.error.empty()) {
+                fprintf(stderr, "Error: %s: %s\n", executable.path.c_str(),
+                        executable.error.c_str());
+                return;
+            }
+            if (verbose) {
+                printf("Bundle of %zu HIP Code Objects:\n", executable.codeObjects.size());
+                printf("Entry ID:\t\t\tURI:\n");
+            }
+            for (const bundle_index::CodeObject& codeObject : executable.codeObjects) {
+                std::string uri = bundle_index::CodeObjectUri(executable.path, codeObject);
+                if (verbose) {
+                    printf("%s\t%s\n", codeObject.triple.c_str(), uri.c_str());
+                } else {
+                    printf("%s\n", uri.c_str());
+                }
+            }
+        });
+    return status;
+}
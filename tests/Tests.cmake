@@ -22,6 +22,9 @@
 # Tests.cmake
 ###############################################################################
 
+# Parse the HIT instructions of all tests at once
+hit_scan(${CMAKE_CURRENT_LIST_DIR}/src ${CMAKE_CURRENT_LIST_DIR}/unit ${CMAKE_CURRENT_LIST_DIR}/performance)
+
 # Add tests
 include_directories(${CMAKE_CURRENT_SOURCE_DIR}/include)
 include_directories(${CMAKE_CURRENT_LIST_DIR}/src)
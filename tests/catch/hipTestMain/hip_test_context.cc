@@ -70,6 +70,7 @@ TestContext::TestContext(int argc, char** argv) {
   setExePath(argc, argv);
   fillConfig();
   parseJsonFile();
+  compileSkipTests();
   parseOptions(argc, argv);
 }
 
@@ -92,17 +93,30 @@ void TestContext::parseOptions(int argc, char** argv) {
   current_test = std::string(argv[1]);
 }
 
-bool TestContext::skipTest() const {
-  // Direct Match
-  auto flags = std::regex::ECMAScript;
+bool TestContext::skipTest() const { return skipTest(current_test); }
+
+bool TestContext::skipTest(const std::string& test_name) const {
+  return has_skip_regex && std::regex_match(test_name, skip_regex);
+}
+
+void TestContext::compileSkipTests() {
+  // One alternation of all the disabled tests, so that a test name is matched once against all
+  // of them instead of building a regex per entry on every check
+  auto flags = std::regex::ECMAScript | std::regex::optimize;
+  std::string combined;
   for (const auto& i : skip_test) {
-    auto regex = std::regex(i.c_str(), flags);
-    if (std::regex_match(current_test, regex)) {
-      return true;
+    try {
+      std::regex check(i, flags);
+    } catch (const std::regex_error& e) {
+      LogPrintf("Ignoring invalid disabled test %s: %s", i.c_str(), e.what());
+      continue;
     }
+    if (!combined.empty()) combined += '|';
+    combined += "(?:" + i + ")";
   }
-  // TODO add test case skip as well
-  return false;
+  if (combined.empty()) return;
+  skip_regex = std::regex(combined, flags);
+  has_skip_regex = true;
 }
 
 std::string TestContext::currentPath() { return fs::current_path().string(); }
@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+"""Runs the test cases of Catch2 test executables in parallel shards.
+
+The test cases are split into shards of about the same expected duration,
+longest first, using the durations recorded by the previous runs. Each shard
+is a process per executable, optionally pinned to a device, and the reports
+of all shards are merged into one JUnit and one JSON report.
+
+    hip_test_runner.py -j 4 --devices 0,1 UnitTests ABMTests
+"""
+
+import argparse
+import heapq
+import json
+import os
+import subprocess
+import sys
+import threading
+import time
+import xml.etree.ElementTree as ET
+
+HISTORY_VERSION = 1
+# Expected duration of a test case that never ran, when there is no history
+DEFAULT_DURATION = 1.0
+FAILED = ("failed", "crashed")
+
+
+class TestCase:
+    def __init__(self, exe, name, order):
+        self.exe = exe
+        self.name = name
+        self.order = order  # position in the executable, to keep the declared order
+        self.expected = DEFAULT_DURATION
+        self.result = "notrun"  # passed, failed, crashed or skipped
+        self.duration = 0.0
+        self.failures = []
+        self.shard = None
+
+    @property
+    def suite(self):
+        return os.path.basename(self.exe)
+
+    @property
+    def key(self):
+        return self.suite + "::" + self.name
+
+
+class Shard:
+    def __init__(self, index, device):
+        self.index = index
+        self.device = device
+        self.tests = []
+        self.expected = 0.0
+        self.duration = 0.0
+
+    def env(self):
+        env = dict(os.environ)
+        if self.device is not None:
+            env["HIP_VISIBLE_DEVICES"] = self.device
+            env["CUDA_VISIBLE_DEVICES"] = self.device
+        return env
+
+    def run(self, output_dir):
+        start = time.time()
+        log_path = os.path.join(output_dir, "shard%d.log" % self.index)
+        with open(log_path, "w") as log:
+            for exe in sorted(set(t.exe for t in self.tests)):
+                remaining = sorted((t for t in self.tests if t.exe == exe), key=lambda t: t.order)
+                run = 0
+                while remaining:
+                    remaining = self.run_process(exe, remaining, output_dir, run, log)
+                    run += 1
+        self.duration = time.time() - start
+
+    def run_process(self, exe, tests, output_dir, run, log):
+        """Runs tests in one process and returns the tests left to run after a crash."""
+        base = os.path.join(output_dir, "shard%d.%s.%d" % (self.index, os.path.basename(exe), run))
+        with open(base + ".txt", "w") as names:
+            for test in tests:
+                names.write(quote_test_name(test.name) + "\n")
+        cmd = [exe, "--input-file", base + ".txt", "--reporter", "xml", "--durations", "yes",
+               "--out", base + ".xml"]
+        log.write("$ %s\n" % " ".join(cmd))
+        log.flush()
+        process = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                 env=self.env(), universal_newlines=True, errors="replace")
+        log.write(process.stdout)
+        status = process.returncode
+
+        by_name = dict((t.name, t) for t in tests)
+        running, fatal, complete = parse_xml_report(base + ".xml", by_name)
+        crashed = by_name.get(running)
+        if crashed is None and fatal is not None and status != 0:
+            # Catch2's fatal error handler closes the report before the process dies
+            crashed = by_name.get(fatal)
+        if crashed is not None:
+            crashed.result = "crashed"
+            crashed.failures.append("%s %s while running this test case"
+                                    % (os.path.basename(exe), describe_status(status)))
+        left = [t for t in tests if t.result == "notrun"]
+        if not left:
+            return []
+        if crashed is not None:
+            # Run the others again, in a new process
+            return left
+        if complete or "HIP_SKIP_THIS_TEST" in process.stdout.splitlines():
+            # Disabled in the config file of the executable, which leaves them out of the report,
+            # or does not write one when all of them are disabled
+            for test in left:
+                test.result = "skipped"
+            return []
+        for test in left:
+            test.result = "crashed"
+            test.failures.append("%s %s before running this test case"
+                                 % (os.path.basename(exe), describe_status(status)))
+        return []
+
+
+def describe_status(status):
+    if status < 0:
+        return "was killed by signal %d" % -status
+    return "exited with status %d" % status
+
+
+def quote_test_name(name):
+    """Quotes a test case name for a Catch2 --input-file."""
+    for c in "\\,\"":
+        name = name.replace(c, "\\" + c)
+    return '"' + name + '"'
+
+
+def list_tests(exe, spec):
+    cmd = [exe] + ([spec] if spec else []) + ["--list-test-names-only"]
+    output = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    tests = []
+    for line in output.splitlines():
+        name = line.strip()
+        if not name or name == "HIP_SKIP_THIS_TEST":
+            continue
+        if name.startswith('"#') and name.endswith('"'):
+            name = name[1:-1]
+        tests.append(TestCase(exe, name, len(tests)))
+    return tests
+
+
+def parse_xml_report(path, tests):
+    """Fills in the results of tests from a Catch2 xml report.
+
+    Returns the name of the test case that was running when the report ends,
+    as it does when a process crashes without Catch2's fatal error handler,
+    the name of the last test case with a fatal error condition, which the
+    handler reports before the process dies, and whether the report is
+    complete.
+    """
+    parser = ET.XMLPullParser(events=("start", "end"))
+    current = None
+    fatal = None
+    complete = False
+    try:
+        with open(path, "rb") as report:
+            parser.feed(report.read())
+        parser.close()
+    except (IOError, ET.ParseError):
+        pass
+    for event, elem in parser.read_events():
+        if elem.tag == "Catch" and event == "end":
+            complete = True
+        if elem.tag != "TestCase":
+            continue
+        if event == "start":
+            current = elem.get("name")
+            continue
+        test = tests.get(current)
+        if elem.find("FatalErrorCondition") is not None:
+            fatal = current
+        current = None
+        result = elem.find("OverallResult")
+        if test is None or result is None:
+            continue
+        test.result = "passed" if result.get("success") == "true" else "failed"
+        test.duration = float(result.get("durationInSeconds", "0"))
+        test.failures.extend(failure_messages(elem))
+    return current, fatal, complete
+
+
+def failure_messages(test_case):
+    messages = []
+    for elem in test_case.iter():
+        where = "%s:%s: " % (elem.get("filename"), elem.get("line")) if elem.get("filename") else ""
+        if elem.tag == "Expression" and elem.get("success") == "false":
+            original = (elem.findtext("Original") or "").strip()
+            expanded = (elem.findtext("Expanded") or "").strip()
+            messages.append("%s%s(%s) with expansion %s" % (where, elem.get("type", ""), original,
+                                                            expanded))
+        elif elem.tag in ("Exception", "FatalErrorCondition", "Failure"):
+            messages.append("%s%s: %s" % (where, elem.tag, (elem.text or "").strip()))
+    return messages
+
+
+def make_shards(tests, count, devices):
+    """Assigns the tests to shards, longest expected test first, each to the least loaded shard."""
+    shards = [Shard(i, devices[i % len(devices)] if devices else None) for i in range(count)]
+    heap = [(0.0, i) for i in range(count)]
+    for test in sorted(tests, key=lambda t: (-t.expected, t.key)):
+        load, index = heapq.heappop(heap)
+        shards[index].tests.append(test)
+        shards[index].expected = load + test.expected
+        test.shard = index
+        heapq.heappush(heap, (shards[index].expected, index))
+    return shards
+
+
+def load_history(path):
+    if not path or not os.path.exists(path):
+        return {}
+    with open(path) as f:
+        history = json.load(f)
+    if history.get("version") != HISTORY_VERSION:
+        return {}
+    return history.get("durations", {})
+
+
+def save_history(path, durations):
+    with open(path + ".tmp", "w") as f:
+        json.dump({"version": HISTORY_VERSION, "durations": durations}, f, indent=1, sort_keys=True)
+    os.replace(path + ".tmp", path)
+
+
+def write_junit(path, tests, wall_time):
+    root = ET.Element("testsuites", tests=str(len(tests)),
+                      failures=str(sum(t.result in FAILED for t in tests)),
+                      skipped=str(sum(t.result == "skipped" for t in tests)),
+                      time="%.3f" % wall_time)
+    for suite in sorted(set(t.suite for t in tests)):
+        cases = [t for t in tests if t.suite == suite]
+        elem = ET.SubElement(root, "testsuite", name=suite, tests=str(len(cases)),
+                             failures=str(sum(t.result in FAILED for t in cases)),
+                             skipped=str(sum(t.result == "skipped" for t in cases)),
+                             time="%.3f" % sum(t.duration for t in cases))
+        for test in cases:
+            case = ET.SubElement(elem, "testcase", classname=suite, name=test.name,
+                                 time="%.3f" % test.duration)
+            if test.result == "skipped":
+                ET.SubElement(case, "skipped")
+            elif test.result in FAILED:
+                failure = ET.SubElement(case, "failure", type=test.result,
+                                        message=test.failures[0] if test.failures else test.result)
+                failure.text = "\n".join(test.failures)
+    ET.ElementTree(root).write(path, encoding="utf-8", xml_declaration=True)
+
+
+def write_json(path, tests, shards, wall_time):
+    report = {
+        "version": HISTORY_VERSION,
+        "wall_time": wall_time,
+        "shards": [{"shard": s.index, "device": s.device, "tests": len(s.tests),
+                    "expected": s.expected, "duration": s.duration} for s in shards],
+        "tests": [{"executable": t.suite, "name": t.name, "result": t.result,
+                   "duration": t.duration, "shard": t.shard, "failures": t.failures}
+                  for t in tests],
+    }
+    with open(path, "w") as f:
+        json.dump(report, f, indent=1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run Catch2 test executables in parallel shards balanced by test duration.")
+    parser.add_argument("executables", nargs="+", help="Catch2 test executables")
+    parser.add_argument("-j", "--shards", type=int, default=0,
+                        help="number of shards run in parallel "
+                             "(default: number of devices, or of cpus)")
+    parser.add_argument("--devices", default="",
+                        help="comma separated devices; shard i only sees device i %% count")
+    parser.add_argument("-t", "--tests", default="",
+                        help="Catch2 test spec selecting the test cases to run")
+    parser.add_argument("--history", default="hip_test_durations.json",
+                        help="json file with the durations of the previous runs, updated at the end")
+    parser.add_argument("-o", "--output-dir", default="hip_test_results",
+                        help="directory for the logs and reports of the shards")
+    parser.add_argument("--junit", help="merged JUnit report (default: <output-dir>/junit.xml)")
+    parser.add_argument("--json", help="merged json report (default: <output-dir>/results.json)")
+    parser.add_argument("-n", "--dry-run", action="store_true",
+                        help="print the shards without running them")
+    args = parser.parse_args()
+
+    devices = [d for d in args.devices.split(",") if d]
+    count = args.shards or len(devices) or os.cpu_count() or 1
+
+    tests = []
+    for exe in args.executables:
+        exe = os.path.abspath(exe)
+        if not os.access(exe, os.X_OK):
+            sys.stderr.write("%s is not an executable\n" % exe)
+            return 2
+        tests.extend(list_tests(exe, args.tests))
+    if not tests:
+        sys.stderr.write("No test cases to run\n")
+        return 2
+
+    history = load_history(args.history)
+    known = sorted(history[t.key] for t in tests if t.key in history)
+    unknown = known[len(known) // 2] if known else DEFAULT_DURATION
+    for test in tests:
+        test.expected = history.get(test.key, unknown)
+
+    shards = make_shards(tests, min(count, len(tests)), devices)
+    for shard in shards:
+        print("shard %d%s: %d test cases, %.1fs expected" % (
+            shard.index, "" if shard.device is None else " (device %s)" % shard.device,
+            len(shard.tests), shard.expected))
+    if args.dry_run:
+        for shard in shards:
+            for test in shard.tests:
+                print("%d %s %.3f" % (shard.index, test.key, test.expected))
+        return 0
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    start = time.time()
+    threads = [threading.Thread(target=s.run, args=(args.output_dir,)) for s in shards]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    wall_time = time.time() - start
+
+    for test in tests:
+        if test.result in ("passed", "failed"):
+            history[test.key] = test.duration
+    if args.history:
+        save_history(args.history, history)
+    write_junit(args.junit or os.path.join(args.output_dir, "junit.xml"), tests, wall_time)
+    write_json(args.json or os.path.join(args.output_dir, "results.json"), tests, shards, wall_time)
+
+    failed = [t for t in tests if t.result in FAILED]
+    skipped = [t for t in tests if t.result == "skipped"]
+    for shard in shards:
+        print("shard %d: %.1fs (%.1fs expected)" % (shard.index, shard.duration, shard.expected))
+    for test in failed:
+        print("%s: %s %s" % (test.result.upper(), test.suite, test.name))
+        for failure in test.failures:
+            print("    " + failure)
+    print("%d test cases, %d failed, %d skipped, %.1fs (%.1fs serial)" % (
+        len(tests), len(failed), len(skipped), wall_time, sum(t.duration for t in tests)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,12 +2,58 @@
 #include <hip_test_common.hh>
 #include <iostream>
 
+// Quotes a test case name for a Catch2 test spec
+static std::string quoteTestName(const std::string& name) {
+  std::string quoted = "\"";
+  for (const auto& c : name) {
+    if (c == '\\' || c == '"' || c == ',') quoted += '\\';
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+// Narrows the test spec of the session down to the selected test cases which are not disabled,
+// so that the disabled ones are skipped in this process. Returns false if all of them are.
+static bool skipDisabledTests(Catch::Session& session) {
+  auto& context = TestContext::get();
+  const auto& data = session.configData();
+  // Listings keep the disabled tests, CTest discovers them and reports them as skipped
+  if (!context.hasDisabledTests() || data.showHelp || data.listTests || data.listTestNamesOnly ||
+      data.listTags || data.listReporters) {
+    return true;
+  }
+
+  auto& config = session.config();
+  auto tests = Catch::filterTests(Catch::getAllTestCasesSorted(config), config.testSpec(), config);
+  std::string spec;
+  bool skipped = false;
+  for (const auto& test : tests) {
+    if (context.skipTest(test.name)) {
+      LogPrintf("Skipping disabled test: %s", test.name.c_str());
+      skipped = true;
+      continue;
+    }
+    if (!spec.empty()) spec += ',';
+    spec += quoteTestName(test.name);
+  }
+  if (!skipped) return true;
+  if (spec.empty()) return false;
+
+  Catch::ConfigData narrowed = data;
+  narrowed.testsOrTags = {spec};
+  session.useConfigData(narrowed);
+  return true;
+}
+
 int main(int argc, char** argv) {
-  auto& context = TestContext::get(argc, argv);
-  if (context.skipTest()) {
+  TestContext::get(argc, argv);
+  Catch::Session session;
+  int status = session.applyCommandLine(argc, argv);
+  if (status != 0) return status;
+  if (!skipDisabledTests(session)) {
     // CTest uses this regex to figure out if the test has been skipped
     std::cout << "HIP_SKIP_THIS_TEST" << std::endl;
     return 0;
   }
-  return Catch::Session().run(argc, argv);
+  return session.run();
 }
@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <regex>
 
 #if defined(_WIN32)
 #define HT_WIN 1
@@ -46,6 +47,8 @@ class TestContext {
   std::string exe_path;
   std::string current_test;
   std::set<std::string> skip_test;
+  std::regex skip_regex;  // All of skip_test, compiled once
+  bool has_skip_regex = false;
 
   Config config_;
 
@@ -55,6 +58,7 @@ class TestContext {
   void setExePath(int, char**);
   void parseOptions(int, char**);
   bool parseJsonFile();
+  void compileSkipTests();
   const Config& getConfig() const { return config_; }
 
   TestContext(int argc, char** argv);
@@ -70,6 +74,8 @@ class TestContext {
   bool isNvidia() const;
   bool isAmd() const;
   bool skipTest() const;
+  bool skipTest(const std::string& test_name) const;
+  bool hasDisabledTests() const { return has_skip_regex; }
 
   const std::string& getCurrentTest() const { return current_test; }
   std::string currentPath();
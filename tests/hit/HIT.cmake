@@ -29,6 +29,9 @@ if (NOT ${BUILD_SHARED_LIBS})
 endif()
 message(STATUS "HIP runtime lib type - ${HIP_LIB_TYPE}")
 message(STATUS "CMAKE_TESTING_TOOL: ${CMAKE_TESTING_TOOL}")
+set(HIT_PARSER ${CMAKE_CURRENT_LIST_DIR}/parser)
+set(HIT_SCAN_COUNT 0)
+set(HIT_SCANNED_DIRS "")
 #-------------------------------------------------------------------------------
 # Helper macro to parse BUILD instructions
 macro(PARSE_BUILD_COMMAND _target _sources _hipcc_options _clang_options _nvcc_options _link_options _exclude_platforms _exclude_runtime _exclude_compiler _exclude_lib_type _depends _dir)
@@ -250,6 +253,60 @@ macro(READ_FROM_MAP _map _key _value)
 endmacro()
 
 
+# Helper macro to read the HIT instructions of one kind (BUILD, BUILD_CMD, TEST or
+# TEST_NAMED) of a scanned file, one per line
+macro(READ_HIT_COMMANDS _cmd _dir _file _contents)
+    if(IS_ABSOLUTE "${_file}")
+        set(_path "${_file}")
+        file(RELATIVE_PATH _relpath "${_dir}" "${_file}")
+    else()
+        set(_path "${_dir}/${_file}")
+        set(_relpath "${_file}")
+    endif()
+    string(REGEX REPLACE "\\.[^.]+$" "" _exe "${_relpath}")
+    set(_var "HIT_${_cmd}_${_path}")
+    string(REPLACE "%s" "${_relpath}" ${_contents} "${${_var}}")   # Substitute %s -> filename
+    string(REPLACE "%t" "${_exe}" ${_contents} "${${_contents}}")  # Substitute %t -> targetname
+endmacro()
+
+# Helper macro to build the sources of a BUILD instruction other than the test file itself,
+# e.g. test_common.cpp, once as a static library for all the tests that list them with the
+# same options. The sources are replaced by the libraries to link, in _libs. Relocatable
+# device code has to be linked with the test, so it is left to the test.
+macro(BUILD_SHARED_SOURCES _file _sources _libs _hipcc_options _clang_options _nvcc_options)
+    set(${_libs})
+    # hip_add_library reuses the option variables of the caller
+    set(_hit_hipcc_options ${${_hipcc_options}})
+    set(_hit_clang_options ${${_clang_options}})
+    set(_hit_nvcc_options ${${_nvcc_options}})
+    string(REPLACE ";" " " _hit_options "${_hit_hipcc_options}|${_hit_clang_options}|${_hit_nvcc_options}")
+    if(NOT _hit_options MATCHES "rdc")
+        set(_hit_sources)
+        foreach(_hit_source ${${_sources}})
+            get_filename_component(_hit_source ${_hit_source} ABSOLUTE)
+            if(_hit_source STREQUAL "${_file}")
+                list(APPEND _hit_sources ${_hit_source})
+            else()
+                string(MD5 _hit_lib "${_hit_source}|${_hit_options}")
+                string(SUBSTRING ${_hit_lib} 0 8 _hit_lib)
+                get_filename_component(_hit_name ${_hit_source} NAME_WE)
+                set(_hit_lib hit.${_hit_name}.${_hit_lib})
+                if(NOT TARGET ${_hit_lib})
+                    set_source_files_properties(${_hit_source} PROPERTIES HIP_SOURCE_PROPERTY_FORMAT 1)
+                    hip_reset_flags()
+                    hip_add_library(${_hit_lib} ${_hit_source} HIPCC_OPTIONS ${_hit_hipcc_options} CLANG_OPTIONS ${_hit_clang_options} NVCC_OPTIONS ${_hit_nvcc_options} STATIC EXCLUDE_FROM_ALL)
+                    set_target_properties(${_hit_lib} PROPERTIES ARCHIVE_OUTPUT_DIRECTORY hit)
+                endif()
+                list(APPEND ${_libs} ${_hit_lib})
+            endif()
+        endforeach()
+        set(${_sources} ${_hit_sources})
+        set(${_hipcc_options} ${_hit_hipcc_options})
+        set(${_clang_options} ${_hit_clang_options})
+        set(${_nvcc_options} ${_hit_nvcc_options})
+    endif()
+endmacro()
+
 # Helper macro to generate a test
 macro(GENERATE_TEST _config testname cmdline)
     set(TEST_CMD_LINE ${cmdline} ${ARGN})
@@ -285,16 +342,45 @@ macro(MAKE_TEST _config exe)
 endmacro()
 #-------------------------------------------------------------------------------
 
+# Macro: HIT_SCAN to parse the HIT instructions of all files under the given files and
+# directories with a single run of the parser. The parser keeps its results in the build
+# tree and only parses the files again that changed since the last configure.
+macro(HIT_SCAN)
+    math(EXPR HIT_SCAN_COUNT "${HIT_SCAN_COUNT} + 1")
+    set(_hit_directives ${PROJECT_BINARY_DIR}/hit/directives${HIT_SCAN_COUNT}.cmake)
+    file(MAKE_DIRECTORY ${PROJECT_BINARY_DIR}/hit)
+    execute_process(COMMAND ${HIT_PARSER} --cmake ${_hit_directives} ${ARGN}
+        ERROR_QUIET)
+    include(${_hit_directives} OPTIONAL)
+    foreach(_hit_path ${ARGN})
+        if(IS_DIRECTORY ${_hit_path})
+            list(APPEND HIT_SCANNED_DIRS ${_hit_path})
+        endif()
+    endforeach()
+endmacro()
+
 # Macro: HIT_ADD_FILES used to scan+add multiple files for testing.
 file(GLOB HIP_LIB_FILES ${HIP_PATH}/lib/*)
 macro(HIT_ADD_FILES _config _dir _label _parent)
+    # Scan the files that are not part of a scanned directory together
+    set(_unscanned)
+    foreach (file ${ARGN})
+        if(IS_ABSOLUTE "${file}")
+            set(_path "${file}")
+        else()
+            set(_path "${_dir}/${file}")
+        endif()
+        if(NOT DEFINED "HIT_SCANNED_${_path}")
+            list(APPEND _unscanned "${_path}")
+        endif()
+    endforeach()
+    if(_unscanned)
+        hit_scan(${_unscanned})
+    endif()
+
     foreach (file ${ARGN})
         # Build tests
-        execute_process(COMMAND ${CMAKE_CURRENT_LIST_DIR}/hit/parser --buildCMDs ${file}
-            OUTPUT_VARIABLE _contents
-            ERROR_QUIET
-            WORKING_DIRECTORY ${_dir}
-            OUTPUT_STRIP_TRAILING_WHITESPACE)
+        read_hit_commands(BUILD ${_dir} ${file} _contents)
         string(REGEX REPLACE "\n" ";" _contents "${_contents}")
         foreach(_cmd ${_contents})
             string(REGEX REPLACE " " ";" _cmd "${_cmd}")
@@ -311,10 +397,12 @@ macro(HIT_ADD_FILES _config _dir _label _parent)
             elseif(${HIP_LIB_TYPE} IN_LIST _exclude_lib_type)
                 insert_into_map("_exclude" "${target}" TRUE)
             else()
+                get_filename_component(_file_path ${file} ABSOLUTE BASE_DIR ${_dir})
+                build_shared_sources(${_file_path} _sources _shared_libs _hipcc_options _clang_options _nvcc_options)
                 set_source_files_properties(${_sources} PROPERTIES HIP_SOURCE_PROPERTY_FORMAT 1)
                 hip_reset_flags()
                 hip_add_executable(${target} ${_sources} HIPCC_OPTIONS ${_hipcc_options} CLANG_OPTIONS ${_clang_options} NVCC_OPTIONS ${_nvcc_options} EXCLUDE_FROM_ALL)
-                target_link_libraries(${target} PRIVATE ${_link_options})
+                target_link_libraries(${target} PRIVATE ${_shared_libs} ${_link_options})
                 set_target_properties(${target} PROPERTIES OUTPUT_NAME ${_target} RUNTIME_OUTPUT_DIRECTORY ${_label} LINK_DEPENDS "${HIP_LIB_FILES}")
                 add_dependencies(${_parent} ${target})
                 foreach(_dependency ${_depends})
@@ -325,11 +413,7 @@ macro(HIT_ADD_FILES _config _dir _label _parent)
         endforeach()
 
         # Custom build commands
-        execute_process(COMMAND ${CMAKE_CURRENT_LIST_DIR}/hit/parser --customBuildCMDs ${file}
-            OUTPUT_VARIABLE _contents
-            ERROR_QUIET
-            WORKING_DIRECTORY ${_dir}
-            OUTPUT_STRIP_TRAILING_WHITESPACE)
+        read_hit_commands(BUILD_CMD ${_dir} ${file} _contents)
         string(REGEX REPLACE "\n" ";" _contents "${_contents}")
         string(REGEX REPLACE "%hc" "${HIP_HIPCC_EXECUTABLE}" _contents "${_contents}")
         string(REGEX REPLACE "%hip-path" "${HIP_ROOT_DIR}" _contents "${_contents}")
@@ -384,11 +468,7 @@ macro(HIT_ADD_FILES _config _dir _label _parent)
         endforeach()
 
         # Add tests
-        execute_process(COMMAND ${CMAKE_CURRENT_LIST_DIR}/hit/parser --testCMDs ${file}
-            OUTPUT_VARIABLE _contents
-            ERROR_QUIET
-            WORKING_DIRECTORY ${_dir}
-            OUTPUT_STRIP_TRAILING_WHITESPACE)
+        read_hit_commands(TEST ${_dir} ${file} _contents)
         string(REGEX REPLACE "\n" ";" _contents "${_contents}")
         foreach(_cmd ${_contents})
             string(REGEX REPLACE " " ";" _cmd "${_cmd}")
@@ -407,11 +487,7 @@ macro(HIT_ADD_FILES _config _dir _label _parent)
         endforeach()
 
         # Add named tests
-        execute_process(COMMAND ${CMAKE_CURRENT_LIST_DIR}/hit/parser --testNamedCMDs ${file}
-            OUTPUT_VARIABLE _contents
-            ERROR_QUIET
-            WORKING_DIRECTORY ${_dir}
-            OUTPUT_STRIP_TRAILING_WHITESPACE)
+        read_hit_commands(TEST_NAMED ${_dir} ${file} _contents)
         string(REGEX REPLACE "\n" ";" _contents "${_contents}")
         foreach(_cmd ${_contents})
             string(REGEX REPLACE " " ";" _cmd "${_cmd}")
@@ -447,6 +523,8 @@ macro(HIT_ADD_DIRECTORY_RECURSIVE _config _dir _label)
     add_custom_target(${_parent})
     if(${ARGC} EQUAL 4)
         add_dependencies(${ARGV3} ${_parent})
+    elseif(NOT ${_dir} IN_LIST HIT_SCANNED_DIRS)
+        hit_scan(${_dir})
     endif()
     file(GLOB children RELATIVE ${_dir} ${_dir}/*)
     set(dirlist "")
@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host conversion rate of float arrays to hip_bfloat16 and back: one element at a time with
+// hip_bfloat16(float), then with every path of hip_bfloat16_from_float_n the host supports.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "test_common.h"
+#include <hip/hip_bfloat16.h>
+
+#define NUM_ELEMENTS (64 << 20)
+#define NUM_ITER 5
+
+using namespace std;
+using namespace hip_bfloat16_detail;
+
+static const char* isaName(host_isa_t isa) {
+  switch (isa) {
+    case host_isa_avx2: return "avx2";
+    case host_isa_avx512: return "avx512";
+    case host_isa_avx512bf16: return "avx512bf16";
+    default: return "scalar";
+  }
+}
+
+template <typename F>
+static double bestTime(F convert) {
+  double best = 1e30;
+  for (int i = 0; i < NUM_ITER; i++) {
+    auto start = chrono::steady_clock::now();
+    convert();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    best = min(best, elapsed.count());
+  }
+  return best;
+}
+
+static void log(const char* title, double sec) {
+  // Bytes read plus bytes written
+  double GBytes = NUM_ELEMENTS * (sizeof(float) + sizeof(hip_bfloat16)) / 1e9;
+  cout << setw(28) << left << title << right << ": " << setw(10) << sec * 1000 << " ms, "
+       << setw(8) << GBytes / sec << " GB/s" << endl;
+}
+
+int main() {
+  vector<float> src(NUM_ELEMENTS), back(NUM_ELEMENTS);
+  vector<hip_bfloat16> dst(NUM_ELEMENTS);
+  mt19937 rng(1234);
+  normal_distribution<float> weights(0.0f, 0.05f);
+  for (auto& f : src) f = weights(rng);
+
+  cout << "Converting " << NUM_ELEMENTS << " elements, best of " << NUM_ITER << " runs" << endl;
+  log("hip_bfloat16(float) loop", bestTime([&]() {
+    for (size_t i = 0; i < src.size(); i++) dst[i] = hip_bfloat16(src[i]);
+  }));
+  vector<hip_bfloat16> expected(dst);
+  log("float(hip_bfloat16) loop", bestTime([&]() {
+    for (size_t i = 0; i < dst.size(); i++) back[i] = float(dst[i]);
+  }));
+
+  uint16_t* bits = reinterpret_cast<uint16_t*>(dst.data());
+  for (int isa = host_isa_scalar; isa <= host_isa(); isa++) {
+    string name = isaName(host_isa_t(isa));
+    log(("from_float_n " + name).c_str(), bestTime([&]() {
+      from_float_n(bits, src.data(), src.size(), host_isa_t(isa));
+    }));
+    if (memcmp(dst.data(), expected.data(), dst.size() * sizeof(hip_bfloat16)) != 0) {
+      failed("from_float_n %s does not match hip_bfloat16(float)", name.c_str());
+    }
+    log(("to_float_n " + name).c_str(), bestTime([&]() {
+      to_float_n(back.data(), bits, dst.size(), host_isa_t(isa));
+    }));
+  }
+  passed();
+}
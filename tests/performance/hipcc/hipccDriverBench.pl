@@ -0,0 +1,106 @@
+#!/usr/bin/perl -w
+
+##
+# Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+##
+
+# Measures the time hipcc adds to every compile, by running it against a stub HIP-Clang that returns
+# immediately, with the compiler run directly and through /bin/sh (HIPCC_USE_SHELL=1).
+# Also checks that both modes pass the same arguments to the compiler.
+#
+#usage hipccDriverBench.pl [-runs N] [-args N] [-hipcc PATH_TO_HIPCC]
+
+use strict;
+use Getopt::Long;
+use File::Basename;
+use File::Spec;
+use File::Temp qw(tempdir);
+use Time::HiRes qw(time);
+
+my $runs = 50;
+my $args = 100;
+my $hipcc = dirname(__FILE__) . "/../../../bin/hipcc";
+
+GetOptions(
+      "runs=i" => \$runs            # Number of compiles in every mode.
+    , "args=i" => \$args            # Number of extra arguments of every compile.
+    , "hipcc=s" => \$hipcc          # hipcc script to benchmark.
+);
+$hipcc = File::Spec->rel2abs($hipcc);
+
+# Stub toolchain: the compiler writes its arguments to the file named by HIPCC_BENCH_ARGS, if set.
+my $root = tempdir("hipccDriverBenchXXXXXX", TMPDIR => 1, CLEANUP => 1);
+mkdir("$root/$_") foreach ("bin", "llvm", "llvm/bin", "llvm/lib", "llvm/lib/clang", "llvm/lib/clang/0.0.0", "llvm/lib/clang/0.0.0/include");
+foreach my $tool ("clang", "clang++") {
+    open(TOOL, ">", "$root/llvm/bin/$tool") or die "error: could not create the stub compiler: $!\n";
+    print TOOL "#!/bin/sh\n",
+               "if [ \"\$1\" = \"--version\" ]; then echo \"clang version 0.0.0\"; exit 0; fi\n",
+               "if [ -n \"\$HIPCC_BENCH_ARGS\" ]; then printf '%s\\n' \"\$@\" > \"\$HIPCC_BENCH_ARGS\"; fi\n";
+    close(TOOL);
+    chmod(0755, "$root/llvm/bin/$tool");
+}
+$ENV{'HIP_PLATFORM'} = "amd";
+$ENV{'HIP_PATH'} = $root;
+$ENV{'ROCM_PATH'} = $root;
+$ENV{'HIP_CLANG_PATH'} = "$root/llvm/bin";
+$ENV{'HIPCC_CACHE_DIR'} = "$root/cache";
+delete $ENV{'HIPCC_VERBOSE'};
+
+my @command = ($^X, $hipcc, "--offload-arch=gfx906", "-c", "bench.cpp", "-o", "bench file.o",
+               map { "-DBENCH_ARG_$_=\"value $_\"" } (1 .. $args));
+
+sub run {
+    my ($useShell) = @_;
+    local $ENV{'HIPCC_USE_SHELL'} = $useShell;
+    # Warm the probe cache first
+    system(@command) == 0 or die "error: hipcc failed\n";
+    my $start = time;
+    for (my $i = 0; $i < $runs; $i++) {
+        system(@command) == 0 or die "error: hipcc failed\n";
+    }
+    my $elapsed = (time - $start) / $runs;
+    local $ENV{'HIPCC_BENCH_ARGS'} = "$root/args.$useShell";
+    system(@command) == 0 or die "error: hipcc failed\n";
+    open(ARGS, "<", "$root/args.$useShell") or die "error: the stub compiler was not run\n";
+    my $compilerArgs = join("", <ARGS>);
+    close(ARGS);
+    return ($elapsed, $compilerArgs);
+}
+
+# The stub compiler alone, for reference
+my $start = time;
+for (my $i = 0; $i < $runs; $i++) {
+    system("$root/llvm/bin/clang++", "-c", "bench.cpp") == 0 or die "error: stub compiler failed\n";
+}
+my $compilerTime = (time - $start) / $runs;
+
+my ($shellTime, $shellArgs) = run(1);
+my ($execTime, $execArgs) = run(0);
+
+printf "%d runs, %d extra arguments per compile\n", $runs, $args;
+printf "stub compiler:         %7.2f ms\n", $compilerTime * 1000;
+printf "hipcc through /bin/sh: %7.2f ms per compile (%.2f ms of overhead)\n", $shellTime * 1000, ($shellTime - $compilerTime) * 1000;
+printf "hipcc direct exec:     %7.2f ms per compile (%.2f ms of overhead)\n", $execTime * 1000, ($execTime - $compilerTime) * 1000;
+if ($shellArgs ne $execArgs) {
+    print "error: the compiler gets different arguments when run directly\n";
+    exit 1;
+}
+print "compiler arguments match\n";
@@ -0,0 +1,124 @@
+#!/usr/bin/perl -w
+
+##
+# Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+##
+
+# Compares hipify-perl-batch's compiled simpleSubstitutions() against the engine of hipify-perl, which applies
+# one s/\bcudaX\b/hipX/g per table entry, on a synthetic CUDA source.
+#
+#usage hipifyPerlSubstitutionBench.pl [-lines N] [-density PERCENT] [-hipify PATH_TO_HIPIFY_PERL_BATCH]
+
+use strict;
+use Getopt::Long;
+use File::Basename;
+use File::Spec;
+use Time::HiRes qw(time);
+
+my $lines = 200000;
+my $density = 10;
+my $hipify = dirname(__FILE__) . "/../../../bin/hipify-perl-batch";
+
+GetOptions(
+      "lines=i" => \$lines          # Number of lines in the synthetic source.
+    , "density=i" => \$density      # Percentage of lines containing a CUDA name.
+    , "hipify=s" => \$hipify        # hipify-perl-batch script to benchmark.
+);
+
+# Load hipify-perl-batch's subroutines and substitution table without processing any files.
+our (@substitutions, %ft);
+{
+    local @ARGV = ();
+    $hipify = File::Spec->rel2abs($hipify);
+    do $hipify;
+    die "error: could not load $hipify: $@$!\n" unless @substitutions;
+}
+
+# The previous engine: one regex per table entry, applied in table order.
+my $sequentialCode = "sub {\n";
+foreach my $rule (@substitutions) {
+    my ($cudaName, $hipName, $stat) = map { quotemeta } @$rule;
+    $sequentialCode .= "    \$ft{'$stat'} += s/\\b$cudaName\\b/$hipName/g;\n";
+}
+$sequentialCode .= "}\n";
+my $sequentialSubstitutions = eval $sequentialCode or die "error: $@";
+
+srand(42);
+my @filler = ("int i = threadIdx.x + blockIdx.x * blockDim.x;", "for (size_t j = 0; j < n; ++j) sum += a[j] * b[j];",
+              "if (err != 0) { fprintf(stderr, \"failed\\n\"); return 1; }", "// plain host code without any CUDA API");
+my $source = "";
+for (my $i = 0; $i < $lines; $i++) {
+    if (rand(100) < $density) {
+        my $name = $substitutions[int(rand(@substitutions))][0];
+        $source .= ($name =~ /^\w+$/) ? "    status = $name(ptr, size);\n" : "#include <$name>\n";
+    } else {
+        $source .= "    " . $filler[int(rand(@filler))] . "\n";
+    }
+}
+
+sub run {
+    my ($engine) = @_;
+    local $_ = $source;
+    my $start = time;
+    $engine->();
+    return (time - $start, $_);
+}
+
+# Both engines count into %ft, so keep the counts of each run apart.
+%ft = ();
+my ($sequentialTime, $sequentialOutput) = run($sequentialSubstitutions);
+my %expected = %ft;
+%ft = ();
+my ($compiledTime, $compiledOutput) = run(\&main::simpleSubstitutions);
+my %compiled = %ft;
+
+printf "input: %d lines, %d bytes, %d substitutions\n", $lines, length($source), scalar(@substitutions);
+printf "sequential: %8.3f s\n", $sequentialTime;
+printf "compiled:   %8.3f s (%.1fx)\n", $compiledTime, $sequentialTime / ($compiledTime || 1e-9);
+if ($sequentialOutput ne $compiledOutput) {
+    print "error: compiled substitutions produce different output\n";
+    exit 1;
+}
+foreach my $stat (sort keys %{{ %expected, %compiled }}) {
+    if (($compiled{$stat} || 0) != ($expected{$stat} || 0)) {
+        printf "error: %s: %d references counted by the compiled substitutions, expected %d\n", $stat,
+            $compiled{$stat} || 0, $expected{$stat} || 0;
+        exit 1;
+    }
+}
+
+# Check the counters through the statistics report of hipify-perl-batch.
+my $sourceFile = "/tmp/hipifyPerlSubstitutionBench.$$.cu";
+open(SOURCE, ">", $sourceFile) or die "error: could not open $sourceFile";
+print SOURCE $source;
+close(SOURCE);
+my $report = `$^X $hipify -examine -quiet-warnings $sourceFile 2>&1`;
+unlink($sourceFile);
+my ($reported) = $report =~ /info: converted \d+ CUDA->HIP refs \( ([^)]*)\)/;
+die "error: no statistics reported by $hipify\n" unless defined $reported;
+foreach my $count (split(' ', $reported)) {
+    my ($stat, $value) = split(':', $count);
+    if ($value != ($expected{$stat} || 0)) {
+        printf "error: %s: %d references counted, expected %d\n", $stat, $value, $expected{$stat} || 0;
+        exit 1;
+    }
+}
+print "outputs and statistics match\n";
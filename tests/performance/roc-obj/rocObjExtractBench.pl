@@ -0,0 +1,116 @@
+#!/usr/bin/perl -w
+
+##
+# Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+##
+
+# Extracts every code object of a synthetic clang offload bundle with roc-obj-extract, checks their
+# content, and compares the extraction rate with the "dd bs=1" copy roc-obj-extract used to do.
+#
+#usage rocObjExtractBench.pl [-objects N] [-size MB] [-dd-size KB] [-extract PATH_TO_ROC_OBJ_EXTRACT]
+
+use strict;
+use Getopt::Long;
+use Digest::MD5;
+use File::Basename;
+use File::Spec;
+use File::Temp qw(tempdir);
+use Time::HiRes qw(time);
+
+my $objects = 32;
+my $size = 8;
+my $ddSize = 256;
+my $extract = dirname(__FILE__) . "/../../../bin/roc-obj-extract";
+
+GetOptions(
+      "objects=i" => \$objects      # Number of code objects in the bundle.
+    , "size=i" => \$size            # Size of every code object, in MB.
+    , "dd-size=i" => \$ddSize       # Size copied with dd bs=1 for reference, in KB. 0 to skip it.
+    , "extract=s" => \$extract      # roc-obj-extract script to benchmark.
+);
+$extract = File::Spec->rel2abs($extract);
+
+# Offload bundle: magic, number of entries, then offset, size, triple size and triple of every entry.
+my $dir = tempdir("rocObjExtractBenchXXXXXX", TMPDIR => 1, CLEANUP => 1);
+my $bundle = "$dir/bench.bundle";
+my $objectSize = $size << 20;
+my @triples = map { sprintf("hipv4-amdgcn-amd-amdhsa--gfx%d", 900 + $_) } (0 .. $objects - 1);
+my $headerSize = 24 + 24 * $objects;
+$headerSize += length($_) foreach (@triples);
+open(BUNDLE, ">", $bundle) or die "error: could not create $bundle: $!\n";
+binmode BUNDLE;
+print BUNDLE "__CLANG_OFFLOAD_BUNDLE__", pack("Q<", $objects);
+for (my $i = 0; $i < $objects; $i++) {
+    print BUNDLE pack("Q< Q< Q<", $headerSize + $i * $objectSize, $objectSize, length($triples[$i])), $triples[$i];
+}
+my $block = pack("N*", 0 .. (1 << 16) - 1);
+for (my $i = 0; $i < $objects; $i++) {
+    # Make every object, and every block of it, different
+    for (my $written = 0; $written < $objectSize; $written += length($block)) {
+        print BUNDLE pack("N N", $i, $written), substr($block, 8, $objectSize - $written - 8);
+    }
+}
+close(BUNDLE);
+
+my @uris = map { "file://$bundle#offset=" . ($headerSize + $_ * $objectSize) . "&size=$objectSize" } (0 .. $objects - 1);
+mkdir("$dir/out");
+my $start = time;
+system("$^X $extract -o $dir/out " . join(" ", map { "'$_'" } @uris) . " < /dev/null") == 0
+    or die "error: roc-obj-extract failed\n";
+my $extractTime = time - $start;
+
+# Check every extracted code object against its range of the bundle
+open(BUNDLE, "<", $bundle) or die "error: could not open $bundle: $!\n";
+binmode BUNDLE;
+for (my $i = 0; $i < $objects; $i++) {
+    my $offset = $headerSize + $i * $objectSize;
+    my $file = "$dir/out/bench.bundle-offset$offset-size$objectSize.co";
+    open(OBJECT, "<", $file) or die "error: $file was not extracted\n";
+    binmode OBJECT;
+    my $extracted = Digest::MD5->new->addfile(*OBJECT)->hexdigest;
+    close(OBJECT);
+    my $expected = Digest::MD5->new;
+    seek(BUNDLE, $offset, 0);
+    for (my $left = $objectSize; $left > 0; ) {
+        my $n = read(BUNDLE, my $buffer, ($left < (8 << 20)) ? $left : 8 << 20) or last;
+        $expected->add($buffer);
+        $left -= $n;
+    }
+    if ($extracted ne $expected->hexdigest) {
+        print "error: $file does not match the bundle\n";
+        exit 1;
+    }
+}
+close(BUNDLE);
+
+my $total = $objects * $objectSize;
+printf "bundle: %d code objects of %d MB\n", $objects, $size;
+printf "roc-obj-extract: %8.3f s, %8.1f MB/s\n", $extractTime, $total / ($extractTime || 1e-9) / (1 << 20);
+if ($ddSize > 0) {
+    $start = time;
+    system("dd if='$bundle' of='$dir/dd.co' skip=$headerSize count=" . ($ddSize << 10) . " bs=1 status=none") == 0
+        or die "error: dd failed\n";
+    my $ddTime = time - $start;
+    my $ddRate = ($ddSize << 10) / ($ddTime || 1e-9);
+    printf "dd bs=1:         %8.3f s for %d KB, %8.1f MB/s, %.1f s projected for the bundle\n",
+           $ddTime, $ddSize, $ddRate / (1 << 20), $total / $ddRate;
+}
+print "extracted code objects match\n";
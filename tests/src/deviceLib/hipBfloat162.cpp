@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../test_common.cpp NVCC_OPTIONS -std=c++11
+ * TEST: %t
+ * HIT_END
+ */
+#include "test_common.h"
+#include <hip/hip_runtime.h>
+#include <hip/hip_bfloat16.h>
+#include <random>
+#include <climits>
+
+#define SIZE 100
+using namespace std;
+
+static random_device dev;
+static mt19937 rng(dev());
+
+inline float getRandomFloat(long min = 10, long max = LONG_MAX) {
+    uniform_real_distribution<float> gen(min, max);
+    return gen(rng);
+}
+
+// Every lane must give the same bits as the hip_bfloat16 operation on its own
+__host__ __device__ bool sameBits(hip_bfloat162 pair, hip_bfloat16 x, hip_bfloat16 y) {
+  return pair.x.data == x.data && pair.y.data == y.data;
+}
+
+__host__ __device__ bool isTrue(hip_bfloat16 lane, bool expected) {
+  return float(lane) == (expected ? 1.0f : 0.0f);
+}
+
+__host__ __device__ void testOperations(const float* fa, const float* fb, const float* fc) {
+  hip_bfloat16 a0(fa[0]), a1(fa[1]), b0(fb[0]), b1(fb[1]), c0(fc[0]), c1(fc[1]);
+  hip_bfloat162 a(make_float2(fa[0], fa[1]));
+  hip_bfloat162 b(b0, b1);
+  hip_bfloat162 c = hip_bfloat162::round_to_bfloat162(make_float2(fc[0], fc[1]));
+  assert(sameBits(a, a0, a1));
+  assert(sameBits(c, c0, c1));
+
+  float2 f = a;
+  assert(f.x == float(a0) && f.y == float(a1));
+  hip_bfloat162 t(make_float2(fa[0], fa[1]), hip_bfloat16::truncate);
+  assert(sameBits(t, hip_bfloat16(fa[0], hip_bfloat16::truncate),
+                  hip_bfloat16(fa[1], hip_bfloat16::truncate)));
+
+  assert(sameBits(a + b, a0 + b0, a1 + b1));
+  assert(sameBits(a - b, a0 - b0, a1 - b1));
+  assert(sameBits(a * b, a0 * b0, a1 * b1));
+  assert(sameBits(a / b, a0 / b0, a1 / b1));
+  assert(sameBits(-a, -a0, -a1));
+  assert(sameBits(+a, a0, a1));
+  assert(sameBits(hip_bfloat162_fma(a, b, c),
+                  hip_bfloat16(fmaf(float(a0), float(b0), float(c0))),
+                  hip_bfloat16(fmaf(float(a1), float(b1), float(c1)))));
+
+  hip_bfloat162 x = a;
+  x += b;
+  assert(x == a + b);
+  x = a;
+  x -= b;
+  assert(x == a - b);
+  x = a;
+  x *= b;
+  assert(x == a * b);
+  x = a;
+  x /= b;
+  assert(x == a / b);
+  assert(a != -a);
+
+  hip_bfloat162 mixed(a0, b1);
+  hip_bfloat162 lt = hip_bfloat162_lt(a, mixed);
+  assert(isTrue(lt.x, false) && isTrue(lt.y, a1 < b1));
+  hip_bfloat162 eq = hip_bfloat162_eq(a, mixed);
+  assert(isTrue(eq.x, true) && isTrue(eq.y, a1 == b1));
+  hip_bfloat162 ne = hip_bfloat162_ne(a, mixed);
+  assert(isTrue(ne.x, false) && isTrue(ne.y, a1 != b1));
+  hip_bfloat162 le = hip_bfloat162_le(a, mixed);
+  assert(isTrue(le.x, true) && isTrue(le.y, a1 <= b1));
+  hip_bfloat162 gt = hip_bfloat162_gt(a, mixed);
+  assert(isTrue(gt.x, false) && isTrue(gt.y, a1 > b1));
+  hip_bfloat162 ge = hip_bfloat162_ge(a, mixed);
+  assert(isTrue(ge.x, true) && isTrue(ge.y, a1 >= b1));
+}
+
+// Pairs are loaded and stored as whole 32-bit words
+__global__ void testOperationsGPU(float* d_a, float* d_b, float* d_c, hip_bfloat162* d_sum) {
+  int id = threadIdx.x;
+  if (id >= SIZE / 2) return;
+  testOperations(d_a + 2 * id, d_b + 2 * id, d_c + 2 * id);
+  hip_bfloat162 a(make_float2(d_a[2 * id], d_a[2 * id + 1]));
+  hip_bfloat162 b(make_float2(d_b[2 * id], d_b[2 * id + 1]));
+  d_sum[id] = a + b;
+}
+
+int main() {
+  float *h_fa, *h_fb, *h_fc;
+  float *d_fa, *d_fb, *d_fc;
+  hip_bfloat162 *h_sum, *d_sum;
+
+  static_assert(sizeof(hip_bfloat162) == 2 * sizeof(hip_bfloat16), "hip_bfloat162 is not packed");
+
+  h_fa = new float[SIZE];
+  h_fb = new float[SIZE];
+  h_fc = new float[SIZE];
+  h_sum = new hip_bfloat162[SIZE / 2];
+  for (int i = 0; i < SIZE; i++) {
+    h_fa[i] = getRandomFloat();
+    h_fb[i] = getRandomFloat();
+    h_fc[i] = getRandomFloat();
+  }
+  for (int i = 0; i < SIZE; i += 2) {
+    testOperations(h_fa + i, h_fb + i, h_fc + i);
+  }
+  cout<<"Host bfloat162 Operations Successful!!"<<endl;
+
+  hipMalloc(&d_fa, sizeof(float) * SIZE);
+  hipMalloc(&d_fb, sizeof(float) * SIZE);
+  hipMalloc(&d_fc, sizeof(float) * SIZE);
+  hipMalloc(&d_sum, sizeof(hip_bfloat162) * SIZE / 2);
+
+  hipMemcpy(d_fa, h_fa, sizeof(float) * SIZE, hipMemcpyHostToDevice);
+  hipMemcpy(d_fb, h_fb, sizeof(float) * SIZE, hipMemcpyHostToDevice);
+  hipMemcpy(d_fc, h_fc, sizeof(float) * SIZE, hipMemcpyHostToDevice);
+
+  hipLaunchKernelGGL(testOperationsGPU, 1, SIZE / 2, 0, 0, d_fa, d_fb, d_fc, d_sum);
+  hipDeviceSynchronize();
+  hipMemcpy(h_sum, d_sum, sizeof(hip_bfloat162) * SIZE / 2, hipMemcpyDeviceToHost);
+  for (int i = 0; i < SIZE / 2; i++) {
+    hip_bfloat162 a(make_float2(h_fa[2 * i], h_fa[2 * i + 1]));
+    hip_bfloat162 b(make_float2(h_fb[2 * i], h_fb[2 * i + 1]));
+    if (!sameBits(h_sum[i], a.x + b.x, a.y + b.y)) {
+      failed("Device sum of pair %d does not match the host", i);
+    }
+  }
+  cout<<"Device bfloat162 Operations Successful!!"<<endl;
+
+  delete[] h_fa;
+  delete[] h_fb;
+  delete[] h_fc;
+  delete[] h_sum;
+  hipFree(d_fa);
+  hipFree(d_fb);
+  hipFree(d_fc);
+  hipFree(d_sum);
+  passed();
+}
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../test_common.cpp NVCC_OPTIONS -std=c++11
+ * TEST: %t
+ * HIT_END
+ */
+
+// Checks hip_bfloat16_from_float_n and hip_bfloat16_to_float_n, with every SIMD path the host
+// supports, against hip_bfloat16(float) and float(hip_bfloat16) for all float and bfloat16 values.
+
+#include "test_common.h"
+#include <hip/hip_bfloat16.h>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace hip_bfloat16_detail;
+
+static const char* isaName(host_isa_t isa) {
+  switch (isa) {
+    case host_isa_avx2: return "avx2";
+    case host_isa_avx512: return "avx512";
+    case host_isa_avx512bf16: return "avx512bf16";
+    default: return "scalar";
+  }
+}
+
+static uint16_t referenceFromFloat(float f) {
+  hip_bfloat16 bf(f);
+  return bf.data;
+}
+
+static float referenceToFloat(uint16_t data) {
+  hip_bfloat16 bf;
+  bf.data = data;
+  return float(bf);
+}
+
+// The reference is computed once per chunk of floats, for all of the paths
+static void testFromFloat(host_isa_t best) {
+  const size_t chunk = 1 << 20;
+  vector<float> src(chunk);
+  vector<uint16_t> expected(chunk), dst(chunk);
+  for (uint64_t base = 0; base < (1ull << 32); base += chunk) {
+    for (size_t i = 0; i < chunk; i++) {
+      uint32_t u = uint32_t(base + i);
+      memcpy(&src[i], &u, sizeof(u));
+      expected[i] = referenceFromFloat(src[i]);
+    }
+    for (int isa = host_isa_scalar; isa <= best; isa++) {
+      from_float_n(dst.data(), src.data(), chunk, host_isa_t(isa));
+      for (size_t i = 0; i < chunk; i++) {
+        if (dst[i] != expected[i]) {
+          failed("%s: 0x%08x converted to 0x%04x instead of 0x%04x", isaName(host_isa_t(isa)),
+                 uint32_t(base + i), dst[i], expected[i]);
+        }
+      }
+    }
+  }
+  cout << "float to bfloat16 conversions match for all floats" << endl;
+}
+
+static void testToFloat(host_isa_t isa) {
+  vector<uint16_t> src(1 << 16);
+  vector<float> dst(1 << 16);
+  for (size_t i = 0; i < src.size(); i++) src[i] = uint16_t(i);
+  to_float_n(dst.data(), src.data(), src.size(), isa);
+  for (size_t i = 0; i < src.size(); i++) {
+    float expected = referenceToFloat(src[i]);
+    if (memcmp(&dst[i], &expected, sizeof(float)) != 0) {
+      failed("%s: 0x%04x not converted to the same float", isaName(isa), src[i]);
+    }
+  }
+}
+
+// Every length and start alignment around the vector widths, to cover the loop tails
+static void testTails(host_isa_t isa) {
+  const size_t maxLength = 100;
+  vector<float> src(maxLength + 16), back(maxLength + 16);
+  for (size_t i = 0; i < src.size(); i++) src[i] = 1.0f / (i + 3) - float(i);
+  src[7] = nanf("");
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t n = 0; n <= maxLength; n++) {
+      // One extra element checks that nothing is written past the end
+      vector<uint16_t> dst(n + 1, 0xdead);
+      from_float_n(dst.data(), src.data() + offset, n, isa);
+      for (size_t i = 0; i < n; i++) {
+        if (dst[i] != referenceFromFloat(src[offset + i])) {
+          failed("%s: element %zu of %zu at offset %zu is wrong", isaName(isa), i, n, offset);
+        }
+      }
+      if (dst[n] != 0xdead) failed("%s: wrote past %zu elements", isaName(isa), n);
+      back[n] = -1.0f;
+      to_float_n(back.data(), dst.data(), n, isa);
+      for (size_t i = 0; i < n; i++) {
+        if (back[i] != referenceToFloat(dst[i]) && back[i] == back[i]) {
+          failed("%s: element %zu of %zu not converted back", isaName(isa), i, n);
+        }
+      }
+      if (back[n] != -1.0f) failed("%s: wrote past %zu floats", isaName(isa), n);
+    }
+  }
+}
+
+int main() {
+  host_isa_t best = host_isa();
+  cout << "Host ISA: " << isaName(best) << endl;
+  for (int isa = host_isa_scalar; isa <= best; isa++) {
+    testTails(host_isa_t(isa));
+    testToFloat(host_isa_t(isa));
+    cout << isaName(host_isa_t(isa)) << " conversions match" << endl;
+  }
+  testFromFloat(best);
+
+  // The public entry points use the best path
+  float f[3] = {1.0f, -2.5f, 3.14159f};
+  hip_bfloat16 bf[3];
+  float back[3];
+  hip_bfloat16_from_float_n(bf, f, 3);
+  hip_bfloat16_to_float_n(back, bf, 3);
+  for (int i = 0; i < 3; i++) {
+    if (bf[i].data != referenceFromFloat(f[i]) || back[i] != referenceToFloat(bf[i].data)) {
+      failed("hip_bfloat16_from_float_n/hip_bfloat16_to_float_n mismatch at %d", i);
+    }
+  }
+  passed();
+}
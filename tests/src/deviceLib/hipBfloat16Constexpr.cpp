@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../test_common.cpp NVCC_OPTIONS -std=c++11
+ * TEST: %t
+ * HIT_END
+ */
+
+// Builds tables of hip_bfloat16 constants at compile time, and checks that they hold the same
+// bits as the conversions at run time, on the host and on the device.
+
+#include "test_common.h"
+#include <hip/hip_runtime.h>
+#include <hip/hip_bfloat16.h>
+#include <limits>
+
+#define SIZE 8
+using namespace std;
+
+// isinf, isnan and iszero are usable in constant expressions with any compiler
+constexpr hip_bfloat16 bfInf(0x7f80, hip_bfloat16::from_bits);
+constexpr hip_bfloat16 bfNan(0x7fc0, hip_bfloat16::from_bits);
+constexpr hip_bfloat16 bfNegZero(0x8000, hip_bfloat16::from_bits);
+static_assert(std::isinf(bfInf) && !std::isnan(bfInf), "isinf is wrong");
+static_assert(std::isnan(bfNan) && !std::isinf(bfNan), "isnan is wrong");
+static_assert(std::iszero(bfNegZero) && std::isinf(-bfInf), "iszero is wrong");
+
+static const float values[SIZE] = {0.0f, -1.0f, 3.14159265f, 1.0f / 3, 1e-40f, 3.4e38f,
+                                   numeric_limits<float>::infinity(),
+                                   numeric_limits<float>::quiet_NaN()};
+
+#if HIP_BFLOAT16_CONSTEXPR_CONVERSIONS
+static_assert(hip_bfloat16(1.0f).data == 0x3f80, "1.0f is not converted at compile time");
+// 0x3f808000 is halfway between 0x3f80 and 0x3f81, and rounds to even
+static_assert(hip_bfloat16(1.00390625f).data == 0x3f80, "rounding is not to nearest even");
+static_assert(hip_bfloat16(1.01171875f).data == 0x3f82, "rounding is not to nearest even");
+static_assert(hip_bfloat16(1.00390625f, hip_bfloat16::truncate).data == 0x3f80,
+              "truncation is wrong");
+static_assert(float(hip_bfloat16(2.5f)) == 2.5f, "operator float is not constexpr");
+static_assert(hip_bfloat16(3.4e38f).data == 0x7f80, "overflow does not round to Inf");
+static_assert(std::isnan(hip_bfloat16(numeric_limits<float>::signaling_NaN())),
+              "signaling NaN is not preserved");
+static_assert(std::isinf(hip_bfloat16::round_to_bfloat16(numeric_limits<float>::infinity())),
+              "Inf is not preserved");
+static_assert(hip_bfloat16(2.0f) * hip_bfloat16(3.0f) == hip_bfloat16(6.0f),
+              "arithmetic is not constexpr");
+static_assert(hip_bfloat16(2.0f) < hip_bfloat16(3.0f), "comparisons are not constexpr");
+static_assert(hip_bfloat162(hip_bfloat16(1.0f), hip_bfloat16(2.0f))
+                  != hip_bfloat162(hip_bfloat16(1.0f), hip_bfloat16(3.0f)),
+              "hip_bfloat162 comparisons are not constexpr");
+
+// A table computed at compile time, e.g. quantization constants
+constexpr hip_bfloat16 table[SIZE] = {
+    hip_bfloat16(0.0f), hip_bfloat16(-1.0f), hip_bfloat16(3.14159265f), hip_bfloat16(1.0f / 3),
+    hip_bfloat16(1e-40f), hip_bfloat16(3.4e38f), hip_bfloat16(numeric_limits<float>::infinity()),
+    hip_bfloat16(numeric_limits<float>::quiet_NaN())};
+#else
+// Without a constexpr bit cast the table is computed at startup
+static const hip_bfloat16 table[SIZE] = {
+    hip_bfloat16(values[0]), hip_bfloat16(values[1]), hip_bfloat16(values[2]),
+    hip_bfloat16(values[3]), hip_bfloat16(values[4]), hip_bfloat16(values[5]),
+    hip_bfloat16(values[6]), hip_bfloat16(values[7])};
+#endif
+
+__global__ void convertGPU(const float* in, hip_bfloat16* out, float* back) {
+  int id = threadIdx.x;
+  if (id >= SIZE) return;
+  out[id] = hip_bfloat16(in[id]);
+  back[id] = float(out[id]);
+}
+
+int main() {
+  cout << "Compile time conversions: " << HIP_BFLOAT16_CONSTEXPR_CONVERSIONS << endl;
+  for (int i = 0; i < SIZE; i++) {
+    // volatile keeps the conversion at run time
+    volatile float value = values[i];
+    if (hip_bfloat16(value).data != table[i].data) {
+      failed("host conversion of %g gives 0x%04x instead of 0x%04x", values[i],
+             hip_bfloat16(value).data, table[i].data);
+    }
+  }
+
+  float *d_in, *d_back;
+  hip_bfloat16* d_out;
+  hip_bfloat16 h_out[SIZE];
+  float h_back[SIZE];
+  HIPCHECK(hipMalloc(&d_in, sizeof(values)));
+  HIPCHECK(hipMalloc(&d_out, sizeof(h_out)));
+  HIPCHECK(hipMalloc(&d_back, sizeof(h_back)));
+  HIPCHECK(hipMemcpy(d_in, values, sizeof(values), hipMemcpyHostToDevice));
+  hipLaunchKernelGGL(convertGPU, 1, SIZE, 0, 0, d_in, d_out, d_back);
+  HIPCHECK(hipMemcpy(h_out, d_out, sizeof(h_out), hipMemcpyDeviceToHost));
+  HIPCHECK(hipMemcpy(h_back, d_back, sizeof(h_back), hipMemcpyDeviceToHost));
+  for (int i = 0; i < SIZE; i++) {
+    if (h_out[i].data != table[i].data) {
+      failed("device conversion of %g gives 0x%04x instead of 0x%04x", values[i], h_out[i].data,
+             table[i].data);
+    }
+    if (!std::isnan(table[i]) && h_back[i] != float(table[i])) {
+      failed("device conversion of 0x%04x back to float is wrong", table[i].data);
+    }
+  }
+  HIPCHECK(hipFree(d_in));
+  HIPCHECK(hipFree(d_out));
+  HIPCHECK(hipFree(d_back));
+  passed();
+}